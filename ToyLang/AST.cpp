@@ -52,6 +52,11 @@ Value ExprCall::accept(ExprVisitor* visitor)
 	return visitor->visit(this);
 }
 
+Value ExprSpawn::accept(ExprVisitor* visitor)
+{
+	return visitor->visit(this);
+}
+
 void StmtExpr::accept(StmtVisitor* visitor)
 {
 	return visitor->visit(this);
@@ -91,3 +96,13 @@ void StmtClass::accept(StmtVisitor* visitor)
 {
 	return visitor->visit(this);
 }
+
+void StmtYield::accept(StmtVisitor* visitor)
+{
+	return visitor->visit(this);
+}
+
+void StmtForIn::accept(StmtVisitor* visitor)
+{
+	return visitor->visit(this);
+}
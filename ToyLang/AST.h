@@ -3,6 +3,7 @@
 #include "Scanner.h"
 #include "Value.h"
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -12,7 +13,13 @@ class ToyFunction;
 
 enum class ExprType
 {
-	Binary, Unary, Literal, VariableGet, VariableSet, Call, MemberGet, MemberSet, ArrayGet, ArraySet
+	Binary, Unary, Literal, VariableGet, VariableSet, Call, MemberGet, MemberSet, ArrayGet, ArraySet, Spawn
+};
+
+// Natives that the Resolver can bind directly at a call site.
+enum class Intrinsic
+{
+	NONE, PRINT, PRINTLN, FLUSH, INPUT, CLOCK, NOW, STR, NUM, SQRT, FLOOR, ABS, MIN, MAX, SIN, COS, POW
 };
 
 class Expr
@@ -153,9 +160,24 @@ public:
 	std::unique_ptr<Expr> callee;
 	std::vector<std::unique_ptr<Expr>> args;
 	Token paren;
+	Intrinsic intrinsic;
 
 	ExprCall(std::unique_ptr<Expr> callee, std::vector<std::unique_ptr<Expr>> args, Token paren)
-		:Expr(ExprType::Call), callee(std::move(callee)), args(std::move(args)), paren(paren)
+		:Expr(ExprType::Call), callee(std::move(callee)), args(std::move(args)), paren(paren), intrinsic(Intrinsic::NONE)
+	{}
+
+	Value accept(ExprVisitor* visitor) override;
+};
+
+// spawn f(args), the callee and arguments are evaluated by the spawner and the call runs as a task.
+class ExprSpawn : public Expr
+{
+public:
+	Token keyword;
+	std::unique_ptr<ExprCall> call;
+
+	ExprSpawn(Token keyword, std::unique_ptr<ExprCall> call)
+		:Expr(ExprType::Spawn), keyword(keyword), call(std::move(call))
 	{}
 
 	Value accept(ExprVisitor* visitor) override;
@@ -185,6 +207,20 @@ public:
 	std::vector<std::unique_ptr<Stmt>> stmts;
 	std::vector<Token> params;
 
+	// Set while the body has not been built, on first call it is parsed from this source range,
+	// or decoded from it when bodyPool is set and the range lies in an AstCache image.
+	// Cleared only after the body is complete, so interpreters on other threads may test it without a lock.
+	std::atomic<bool> lazy{ false };
+	// Set when building the lazy body failed, it stays lazy and every call reports the error again.
+	bool bodyFailed = false;
+	// Set when the body contains yield, calls then return a Generator over the body instead of running it.
+	bool generator = false;
+	const char* bodyStart = nullptr;
+	size_t bodyLength = 0;
+	int bodyLine = 0;
+	const char* bodyPool = nullptr;
+	size_t bodyPoolSize = 0;
+
 	StmtFunction(Token name, std::vector<std::unique_ptr<Stmt>> stmts, std::vector<Token> params)
 		: name(name), stmts(std::move(stmts)), params(params) {}
 
@@ -256,6 +292,34 @@ public:
 	void accept(StmtVisitor* visitor) override;
 };
 
+class StmtYield : public Stmt
+{
+public:
+	Token keyword;
+	std::unique_ptr<Expr> expr;
+
+	StmtYield(Token keyword, std::unique_ptr<Expr> expr)
+		: keyword(keyword), expr(std::move(expr))
+	{}
+
+	void accept(StmtVisitor* visitor) override;
+};
+
+// for (name in iterable) body, over Arrays, Float64Arrays and objects with hasNext() and next().
+class StmtForIn : public Stmt
+{
+public:
+	Token name;
+	std::unique_ptr<Expr> iterable;
+	std::unique_ptr<Stmt> body;
+
+	StmtForIn(Token name, std::unique_ptr<Expr> iterable, std::unique_ptr<Stmt> body)
+		: name(name), iterable(std::move(iterable)), body(std::move(body))
+	{}
+
+	void accept(StmtVisitor* visitor) override;
+};
+
 class StmtClass : public Stmt
 {
 public:
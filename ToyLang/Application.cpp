@@ -1,64 +1,86 @@
-#define DEBUG_TREE false
-
+#include <chrono>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 
-#include "Debug.hpp"
-
 #include "Scanner.h"
-#include "Parser.h"
-#include "Interpreter.h"
+#include "ParallelScanner.h"
+#include "Script.h"
+#include "Server.h"
 
 // TODO: Inheritance
 
-void run(const char* filePath)
+// --snapshot only runs the script up to init() and saves its globals, --use-snapshot starts from them.
+void run(const char* filePath, const std::vector<std::string>& args, SnapshotMode snapshot)
 {
-    std::ifstream file(filePath);
-    if (file.fail())
-    {
-        std::cout << "[ERROR] Unable to find file with path: " << filePath << std::endl;
+    std::unique_ptr<Script> script = Script::load(filePath);
+    if (!script)
         return;
-    }
-
-    std::stringstream sourceStream;
-    sourceStream << file.rdbuf();
-    std::string source = sourceStream.str();
 
-    Scanner scanner(source);
-    std::vector<Token> tokens = scanner.scanTokens();
-    // for (auto& token : tokens)
-    //     std::cout << token << std::endl;
-
-    Parser parser(tokens);
-    std::vector<std::unique_ptr<Stmt>> root = parser.parse();
-
-    if (!parser.hadError) {
-        std::vector<Stmt*> root_ref;
-        root_ref.reserve(root.capacity());
+    bool clean = script->run(args, Output::standard(), snapshot);
+    script->finish(clean);
+}
 
-        for (auto& u_ptr : root)
-            root_ref.push_back(u_ptr.get());
+template<typename F>
+static void measureLex(const char* name, size_t bytes, F scan)
+{
+    size_t runs = 0;
+    size_t tokenCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (runs < 5 || elapsed < 1.0)
+    {
+        tokenCount = scan();
+        runs++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
 
-#if DEBUG_TREE
-        AstDebugger astDebugger(root_ref);
-        astDebugger.debug();
-#endif
+    double megabytes = (double)bytes * runs / (1024 * 1024);
+    std::cout << name << ": lexed " << bytes << " bytes into " << tokenCount << " tokens, " << runs << " runs in " << elapsed << "s: "
+        << megabytes / elapsed << " MB/s" << std::endl;
+}
 
-        Interpreter interpreter(root_ref);
-        interpreter.run();
+// Scans the file repeatedly for at least a second, on one thread and then on all cores, and reports lexer throughput.
+void benchLex(const char* filePath)
+{
+    std::shared_ptr<SourceBuffer> source = SourceBuffer::load(filePath);
+    if (!source)
+    {
+        std::cout << "[ERROR] Unable to find file with path: " << filePath << std::endl;
+        return;
     }
+
+    measureLex("sequential", source->size(), [&]() {
+        return Scanner(source->data(), source->size()).scanTokens().size();
+    });
+    measureLex("parallel", source->size(), [&]() {
+        return ParallelScanner(source->data(), source->size()).scanTokens(ThreadPool::shared()).size();
+    });
 }
 
 int main(int argc, char* argv[])
 {
-    if (argc != 2)
+    if (argc == 3 && std::string(argv[1]) == "--bench-lex")
+    {
+        benchLex(argv[2]);
+        return 0;
+    }
+
+    if (argc == 3 && std::string(argv[1]) == "--serve")
+        return Server(argv[2]).serve() ? 0 : 1;
+
+    SnapshotMode snapshot = SnapshotMode::NONE;
+    if (argc >= 2 && std::string(argv[1]) == "--snapshot")
+        snapshot = SnapshotMode::WRITE;
+    else if (argc >= 2 && std::string(argv[1]) == "--use-snapshot")
+        snapshot = SnapshotMode::USE;
+    int scriptArg = snapshot == SnapshotMode::NONE ? 1 : 2;
+    if (argc <= scriptArg)
     {
         std::cout << "[ERROR] Invalid command line argument count." << std::endl;
         return 1;
     }
 
-    run(argv[1]);
+    // Everything after the script path is handed to the script as args.
+    run(argv[scriptArg], std::vector<std::string>(argv + scriptArg + 1, argv + argc), snapshot);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,724 @@
+#include "AstCache.h"
+#include "AstVisitor.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MAGIC[4] = { 'T', 'O', 'Y', 'C' };
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+		uint32_t rootCount;
+		uint32_t assignedCount;
+		uint32_t poolSize;
+		uint64_t treeSize;
+		// Hash of the pool and tree, catches damage that still decodes.
+		uint64_t payloadHash;
+	};
+
+	// Node tags, expressions use their ExprType value.
+	enum : uint8_t
+	{
+		NODE_NULL = 0xFF,
+		NODE_STMT_EXPR = 0x20,
+		NODE_STMT_FUNCTION,
+		NODE_STMT_VAR_DECL,
+		NODE_STMT_BLOCK,
+		NODE_STMT_IF,
+		NODE_STMT_WHILE,
+		NODE_STMT_RETURN,
+		NODE_STMT_CLASS,
+		NODE_STMT_YIELD,
+		NODE_STMT_FOR_IN
+	};
+
+	struct CorruptCache {};
+
+	class Writer : public ExprVisitor, public StmtVisitor
+	{
+	private:
+		std::unordered_map<std::string, uint32_t> interned;
+
+		template<typename T>
+		void put(T val)
+		{
+			tree.append((const char*)&val, sizeof(T));
+		}
+
+		uint32_t intern(const char* str, size_t length)
+		{
+			auto it = interned.emplace(std::string(str, length), (uint32_t)pool.size());
+			if (it.second)
+				pool.append(str, length);
+			return it.first->second;
+		}
+
+		void token(const Token& token)
+		{
+			put<uint8_t>((uint8_t)token.type);
+			put<uint32_t>((uint32_t)token.line);
+			put<uint32_t>(intern(token.start, token.length));
+			put<uint32_t>((uint32_t)token.length);
+		}
+
+		void expr(Expr* expr)
+		{
+			if (expr)
+				expr->accept(this);
+			else
+				put<uint8_t>(NODE_NULL);
+		}
+
+		void stmts(const std::vector<std::unique_ptr<Stmt>>& stmts)
+		{
+			put<uint32_t>((uint32_t)stmts.size());
+			for (auto& s : stmts)
+				stmt(s.get());
+		}
+
+		void function(StmtFunction* stmt)
+		{
+			if (stmt->lazy)
+				throw CorruptCache();
+			token(stmt->name);
+			put<uint32_t>((uint32_t)stmt->params.size());
+			for (auto& p : stmt->params)
+				token(p);
+			put<uint8_t>(stmt->generator ? 1 : 0);
+
+			// The body size is patched in afterwards so the reader can skip the body.
+			size_t sizeAt = tree.size();
+			put<uint32_t>(0);
+			stmts(stmt->stmts);
+			uint32_t size = (uint32_t)(tree.size() - sizeAt - sizeof(uint32_t));
+			memcpy(&tree[sizeAt], &size, sizeof(size));
+		}
+
+	public:
+		std::string pool;
+		std::string tree;
+		std::unordered_set<std::string> assigned;
+
+		void names()
+		{
+			for (auto& name : assigned)
+			{
+				put<uint32_t>(intern(name.data(), name.size()));
+				put<uint32_t>((uint32_t)name.size());
+			}
+		}
+
+		void stmt(Stmt* stmt)
+		{
+			if (stmt)
+				stmt->accept(this);
+			else
+				put<uint8_t>(NODE_NULL);
+		}
+
+		Value visit(ExprBinary* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::Binary);
+			expr(e->lhs.get());
+			expr(e->rhs.get());
+			token(e->op);
+			return Value();
+		}
+
+		Value visit(ExprUnary* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::Unary);
+			expr(e->rhs.get());
+			token(e->op);
+			return Value();
+		}
+
+		Value visit(ExprLiteral* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::Literal);
+			put<uint8_t>((uint8_t)e->value.tag);
+			switch (e->value.tag)
+			{
+			case TypeTag::BOOL:
+				put<uint8_t>(std::get<bool>(e->value.data) ? 1 : 0);
+				break;
+			case TypeTag::NUMBER:
+				put<double>(std::get<double>(e->value.data));
+				break;
+			case TypeTag::STRING:
+			{
+				const std::string& str = std::get<std::string>(e->value.data);
+				put<uint32_t>(intern(str.data(), str.size()));
+				put<uint32_t>((uint32_t)str.size());
+				break;
+			}
+			default:
+				throw CorruptCache();
+			}
+			return Value();
+		}
+
+		Value visit(ExprVariableGet* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::VariableGet);
+			token(e->name);
+			return Value();
+		}
+
+		Value visit(ExprVariableSet* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::VariableSet);
+			assigned.insert(e->name.getLexeme());
+			token(e->name);
+			expr(e->setVal.get());
+			token(e->op);
+			return Value();
+		}
+
+		Value visit(ExprCall* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::Call);
+			expr(e->callee.get());
+			put<uint32_t>((uint32_t)e->args.size());
+			for (auto& a : e->args)
+				expr(a.get());
+			token(e->paren);
+			return Value();
+		}
+
+		Value visit(ExprSpawn* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::Spawn);
+			token(e->keyword);
+			expr(e->call.get());
+			return Value();
+		}
+
+		Value visit(ExprMemberGet* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::MemberGet);
+			token(e->name);
+			expr(e->object.get());
+			return Value();
+		}
+
+		Value visit(ExprMemberSet* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::MemberSet);
+			token(e->name);
+			expr(e->object.get());
+			expr(e->val.get());
+			token(e->op);
+			return Value();
+		}
+
+		Value visit(ExprArrayGet* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::ArrayGet);
+			token(e->paren);
+			expr(e->object.get());
+			expr(e->index.get());
+			return Value();
+		}
+
+		Value visit(ExprArraySet* e) override
+		{
+			put<uint8_t>((uint8_t)ExprType::ArraySet);
+			token(e->paren);
+			expr(e->object.get());
+			expr(e->index.get());
+			expr(e->val.get());
+			token(e->op);
+			return Value();
+		}
+
+		void visit(StmtExpr* s) override
+		{
+			put<uint8_t>(NODE_STMT_EXPR);
+			expr(s->expr.get());
+		}
+
+		void visit(StmtFunction* s) override
+		{
+			put<uint8_t>(NODE_STMT_FUNCTION);
+			function(s);
+		}
+
+		void visit(StmtVarDecl* s) override
+		{
+			put<uint8_t>(NODE_STMT_VAR_DECL);
+			token(s->name);
+			expr(s->initVal.get());
+		}
+
+		void visit(StmtBlock* s) override
+		{
+			put<uint8_t>(NODE_STMT_BLOCK);
+			stmts(s->stmts);
+		}
+
+		void visit(StmtIf* s) override
+		{
+			put<uint8_t>(NODE_STMT_IF);
+			expr(s->cond.get());
+			token(s->paren);
+			stmt(s->then.get());
+			stmt(s->els.get());
+		}
+
+		void visit(StmtWhile* s) override
+		{
+			put<uint8_t>(NODE_STMT_WHILE);
+			expr(s->cond.get());
+			token(s->paren);
+			stmt(s->then.get());
+		}
+
+		void visit(StmtReturn* s) override
+		{
+			put<uint8_t>(NODE_STMT_RETURN);
+			expr(s->expr.get());
+		}
+
+		void visit(StmtClass* s) override
+		{
+			put<uint8_t>(NODE_STMT_CLASS);
+			token(s->name);
+			put<uint32_t>((uint32_t)s->methods.size());
+			for (auto& m : s->methods)
+				function(m.get());
+		}
+
+		void visit(StmtYield* s) override
+		{
+			put<uint8_t>(NODE_STMT_YIELD);
+			token(s->keyword);
+			expr(s->expr.get());
+		}
+
+		void visit(StmtForIn* s) override
+		{
+			put<uint8_t>(NODE_STMT_FOR_IN);
+			token(s->name);
+			expr(s->iterable.get());
+			stmt(s->body.get());
+		}
+	};
+
+	class Reader
+	{
+	private:
+		const char* p;
+		const char* end;
+		const char* pool;
+		size_t poolSize;
+		// Set while validating, function bodies are decoded and dropped instead of skipped.
+		bool checking;
+
+		template<typename T>
+		T get()
+		{
+			if ((size_t)(end - p) < sizeof(T))
+				throw CorruptCache();
+			T val;
+			memcpy(&val, p, sizeof(T));
+			p += sizeof(T);
+			return val;
+		}
+
+		const char* string(uint32_t offset, uint32_t length)
+		{
+			if ((size_t)offset + length > poolSize)
+				throw CorruptCache();
+			return pool + offset;
+		}
+
+		Token token()
+		{
+			TokenType type = (TokenType)get<uint8_t>();
+			int line = (int)get<uint32_t>();
+			uint32_t offset = get<uint32_t>();
+			uint32_t length = get<uint32_t>();
+			return Token(type, line, string(offset, length), (int)length);
+		}
+
+	public:
+		Reader(const char* tree, size_t treeSize, const char* pool, size_t poolSize, bool checking = false)
+			: p(tree), end(tree + treeSize), pool(pool), poolSize(poolSize), checking(checking)
+		{}
+
+		std::vector<std::unique_ptr<Stmt>> stmts()
+		{
+			uint32_t count = get<uint32_t>();
+			std::vector<std::unique_ptr<Stmt>> res;
+			res.reserve(count < 1024 ? count : 1024);
+			for (uint32_t i = 0; i < count; i++)
+				res.push_back(stmt());
+			return res;
+		}
+
+		std::unique_ptr<StmtFunction> function()
+		{
+			Token name = token();
+			uint32_t paramCount = get<uint32_t>();
+			std::vector<Token> params;
+			for (uint32_t i = 0; i < paramCount; i++)
+				params.push_back(token());
+			bool generator = get<uint8_t>() != 0;
+
+			uint32_t size = get<uint32_t>();
+			if ((size_t)(end - p) < size)
+				throw CorruptCache();
+			if (checking)
+			{
+				Reader body(p, size, pool, poolSize, true);
+				body.stmts();
+				if (!body.atEnd())
+					throw CorruptCache();
+			}
+			std::unique_ptr<StmtFunction> func = std::make_unique<StmtFunction>(name, std::vector<std::unique_ptr<Stmt>>(), params);
+			func->lazy = true;
+			func->generator = generator;
+			func->bodyStart = p;
+			func->bodyLength = size;
+			func->bodyLine = name.line;
+			func->bodyPool = pool;
+			func->bodyPoolSize = poolSize;
+			p += size;
+			return func;
+		}
+
+		std::string name()
+		{
+			uint32_t offset = get<uint32_t>();
+			uint32_t length = get<uint32_t>();
+			return std::string(string(offset, length), length);
+		}
+
+		std::unique_ptr<Expr> expr()
+		{
+			uint8_t tag = get<uint8_t>();
+			if (tag == NODE_NULL)
+				return nullptr;
+
+			switch ((ExprType)tag)
+			{
+			case ExprType::Binary:
+			{
+				std::unique_ptr<Expr> lhs = expr();
+				std::unique_ptr<Expr> rhs = expr();
+				return std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), token());
+			}
+			case ExprType::Unary:
+			{
+				std::unique_ptr<Expr> rhs = expr();
+				return std::make_unique<ExprUnary>(std::move(rhs), token());
+			}
+			case ExprType::Literal:
+			{
+				switch ((TypeTag)get<uint8_t>())
+				{
+				case TypeTag::BOOL:
+					return std::make_unique<ExprLiteral>(Value(get<uint8_t>() != 0));
+				case TypeTag::NUMBER:
+					return std::make_unique<ExprLiteral>(Value(get<double>()));
+				case TypeTag::STRING:
+				{
+					uint32_t offset = get<uint32_t>();
+					uint32_t length = get<uint32_t>();
+					return std::make_unique<ExprLiteral>(Value(std::string(string(offset, length), length)));
+				}
+				default:
+					throw CorruptCache();
+				}
+			}
+			case ExprType::VariableGet:
+				return std::make_unique<ExprVariableGet>(token());
+			case ExprType::VariableSet:
+			{
+				Token name = token();
+				std::unique_ptr<Expr> val = expr();
+				return std::make_unique<ExprVariableSet>(name, std::move(val), token());
+			}
+			case ExprType::Call:
+			{
+				std::unique_ptr<Expr> callee = expr();
+				uint32_t count = get<uint32_t>();
+				std::vector<std::unique_ptr<Expr>> args;
+				for (uint32_t i = 0; i < count; i++)
+					args.push_back(expr());
+				return std::make_unique<ExprCall>(std::move(callee), std::move(args), token());
+			}
+			case ExprType::MemberGet:
+			{
+				Token name = token();
+				return std::make_unique<ExprMemberGet>(name, expr());
+			}
+			case ExprType::MemberSet:
+			{
+				Token name = token();
+				std::unique_ptr<Expr> object = expr();
+				std::unique_ptr<Expr> val = expr();
+				return std::make_unique<ExprMemberSet>(name, std::move(object), std::move(val), token());
+			}
+			case ExprType::ArrayGet:
+			{
+				Token paren = token();
+				std::unique_ptr<Expr> object = expr();
+				std::unique_ptr<Expr> index = expr();
+				return std::make_unique<ExprArrayGet>(paren, std::move(object), std::move(index));
+			}
+			case ExprType::ArraySet:
+			{
+				Token paren = token();
+				std::unique_ptr<Expr> object = expr();
+				std::unique_ptr<Expr> index = expr();
+				std::unique_ptr<Expr> val = expr();
+				return std::make_unique<ExprArraySet>(paren, std::move(object), std::move(index), std::move(val), token());
+			}
+			case ExprType::Spawn:
+			{
+				Token keyword = token();
+				std::unique_ptr<Expr> call = expr();
+				if (!call || call->instance != ExprType::Call)
+					throw CorruptCache();
+				return std::make_unique<ExprSpawn>(keyword, std::unique_ptr<ExprCall>((ExprCall*)call.release()));
+			}
+			default:
+				throw CorruptCache();
+			}
+		}
+
+		std::unique_ptr<Stmt> stmt()
+		{
+			switch (get<uint8_t>())
+			{
+			case NODE_NULL:
+				return nullptr;
+			case NODE_STMT_EXPR:
+				return std::make_unique<StmtExpr>(expr());
+			case NODE_STMT_FUNCTION:
+				return function();
+			case NODE_STMT_VAR_DECL:
+			{
+				Token name = token();
+				return std::make_unique<StmtVarDecl>(name, expr());
+			}
+			case NODE_STMT_BLOCK:
+				return std::make_unique<StmtBlock>(stmts());
+			case NODE_STMT_IF:
+			{
+				std::unique_ptr<Expr> cond = expr();
+				Token paren = token();
+				std::unique_ptr<Stmt> then = stmt();
+				std::unique_ptr<Stmt> els = stmt();
+				return std::make_unique<StmtIf>(std::move(cond), paren, std::move(then), std::move(els));
+			}
+			case NODE_STMT_WHILE:
+			{
+				std::unique_ptr<Expr> cond = expr();
+				Token paren = token();
+				return std::make_unique<StmtWhile>(std::move(cond), paren, stmt());
+			}
+			case NODE_STMT_RETURN:
+				return std::make_unique<StmtReturn>(expr());
+			case NODE_STMT_CLASS:
+			{
+				Token name = token();
+				uint32_t count = get<uint32_t>();
+				std::vector<std::unique_ptr<StmtFunction>> methods;
+				for (uint32_t i = 0; i < count; i++)
+					methods.push_back(function());
+				return std::make_unique<StmtClass>(name, std::move(methods));
+			}
+			case NODE_STMT_YIELD:
+			{
+				Token keyword = token();
+				return std::make_unique<StmtYield>(keyword, expr());
+			}
+			case NODE_STMT_FOR_IN:
+			{
+				Token name = token();
+				std::unique_ptr<Expr> iterable = expr();
+				return std::make_unique<StmtForIn>(name, std::move(iterable), stmt());
+			}
+			default:
+				throw CorruptCache();
+			}
+		}
+
+		bool atEnd() const
+		{
+			return p == end;
+		}
+	};
+}
+
+std::string AstCache::pathFor(const std::string& scriptPath)
+{
+	return scriptPath + "c";
+}
+
+uint64_t AstCache::hashSource(const char* data, size_t size, uint64_t hash)
+{
+	// FNV-1a
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+bool AstCache::load(const std::string& cachePath, Program& program, std::unordered_set<std::string>& assigned)
+{
+	std::shared_ptr<SourceBuffer> cache = SourceBuffer::load(cachePath, true);
+	if (!cache || cache->size() < sizeof(Header))
+		return false;
+
+	Header header;
+	memcpy(&header, cache->data(), sizeof(Header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.sourceSize != program.source->size()
+		|| header.sourceHash != hashSource(program.source->data(), program.source->size())
+		|| sizeof(Header) + (uint64_t)header.poolSize + header.treeSize != cache->size()
+		|| header.payloadHash != hashSource(cache->data() + sizeof(Header), cache->size() - sizeof(Header)))
+		return false;
+
+	// Every body is decoded once here and dropped, so a damaged image is a miss and the script is
+	// parsed instead of failing when the body is first called.
+	const char* pool = cache->data() + sizeof(Header);
+	Reader reader(pool + header.poolSize, (size_t)header.treeSize, pool, header.poolSize, true);
+	std::vector<std::unique_ptr<Stmt>> root;
+	try
+	{
+		for (uint32_t i = 0; i < header.rootCount; i++)
+			root.push_back(reader.stmt());
+		for (uint32_t i = 0; i < header.assignedCount; i++)
+			assigned.insert(reader.name());
+		if (!reader.atEnd())
+			return false;
+	}
+	catch (CorruptCache)
+	{
+		return false;
+	}
+
+	program.root = std::move(root);
+	program.cache = cache;
+	return true;
+}
+
+bool AstCache::decodeBody(StmtFunction* func)
+{
+	Reader reader(func->bodyStart, func->bodyLength, func->bodyPool, func->bodyPoolSize);
+	try
+	{
+		func->stmts = reader.stmts();
+		if (!reader.atEnd())
+			return false;
+	}
+	catch (CorruptCache)
+	{
+		return false;
+	}
+	return true;
+}
+
+FILE* AstCache::createTemp(const std::string& path, std::string& tempPath)
+{
+#ifdef _WIN32
+	for (int attempt = 0; attempt < 16; attempt++)
+	{
+		tempPath = path + "." + std::to_string(_getpid()) + "." + std::to_string(attempt) + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wbx");
+		if (file)
+			return file;
+	}
+	return nullptr;
+#else
+	std::string pattern = path + "." + std::to_string(getpid()) + ".XXXXXX";
+	int fd = mkstemp(&pattern[0]);
+	if (fd < 0)
+		return nullptr;
+	tempPath = pattern;
+	// mkstemp creates the file for the owner only, caches are readable like the script.
+	fchmod(fd, 0644);
+	FILE* file = fdopen(fd, "wb");
+	if (!file)
+	{
+		close(fd);
+		remove(tempPath.c_str());
+	}
+	return file;
+#endif
+}
+
+bool AstCache::replaceWith(const std::string& tempPath, const std::string& path)
+{
+	if (rename(tempPath.c_str(), path.c_str()) == 0)
+		return true;
+	// rename does not replace an existing file on Windows
+	remove(path.c_str());
+	if (rename(tempPath.c_str(), path.c_str()) == 0)
+		return true;
+	remove(tempPath.c_str());
+	return false;
+}
+
+bool AstCache::store(const std::string& cachePath, const Program& program)
+{
+	Writer writer;
+	try
+	{
+		for (auto& stmt : program.root)
+			writer.stmt(stmt.get());
+		writer.names();
+	}
+	catch (CorruptCache)
+	{
+		return false;
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sourceHash = hashSource(program.source->data(), program.source->size());
+	header.sourceSize = program.source->size();
+	header.rootCount = (uint32_t)program.root.size();
+	header.assignedCount = (uint32_t)writer.assigned.size();
+	header.poolSize = (uint32_t)writer.pool.size();
+	header.treeSize = writer.tree.size();
+	header.payloadHash = hashSource(writer.pool.data(), writer.pool.size());
+	header.payloadHash = hashSource(writer.tree.data(), writer.tree.size(), header.payloadHash);
+
+	// Each run writes under a name of its own so runs storing at the same time do not mix their writes.
+	std::string tempPath;
+	FILE* file = createTemp(cachePath, tempPath);
+	if (!file)
+		return false;
+	bool written = fwrite(&header, sizeof(Header), 1, file) == 1
+		&& fwrite(writer.pool.data(), 1, writer.pool.size(), file) == writer.pool.size()
+		&& fwrite(writer.tree.data(), 1, writer.tree.size(), file) == writer.tree.size();
+	written = fclose(file) == 0 && written;
+	if (!written)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+	return replaceWith(tempPath, cachePath);
+}
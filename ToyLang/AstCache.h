@@ -0,0 +1,39 @@
+#pragma once
+#include "Source.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+
+// Binary image of a parsed program kept next to the script as "<script>c". It holds a string
+// pool for lexemes and string constants followed by the tree, and is only used while the
+// source hash and format version in its header match. Tokens of a loaded tree point into the
+// mapped pool, so the program keeps the cache mapped for as long as the tree lives. Function
+// bodies are size prefixed and decoded on first call, like bodies the parser skipped; load()
+// decodes each once to check it, so a damaged image is a miss rather than a failing call.
+class AstCache
+{
+public:
+	// Bump whenever the tree layout or the encoding changes.
+	static constexpr uint32_t VERSION = 4;
+
+	static std::string pathFor(const std::string& scriptPath);
+	// FNV-1a, pass the previous result as hash to continue over data that is not contiguous.
+	static uint64_t hashSource(const char* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL);
+
+	// Fills program.root from the cache, program.source must be loaded. Returns false on a miss.
+	// assigned receives every variable name assigned in the program, for the Resolver.
+	static bool load(const std::string& cachePath, Program& program, std::unordered_set<std::string>& assigned);
+	// Builds a body left lazy by load(), returns false if the image is damaged.
+	static bool decodeBody(StmtFunction* func);
+	// Writes the fully parsed tree of program, returns false if it can not be written.
+	static bool store(const std::string& cachePath, const Program& program);
+
+	// Files other runs may have mapped are written aside with these and renamed over the old one, so a
+	// run never maps a partial file. Creates a file next to path that no other run writes to and puts
+	// its name in tempPath, returns null if it can not.
+	static FILE* createTemp(const std::string& path, std::string& tempPath);
+	// Renames the closed temp file over path, or removes it if that fails.
+	static bool replaceWith(const std::string& tempPath, const std::string& path);
+};
@@ -14,6 +14,7 @@ public:
     virtual Value visit(ExprArrayGet* expr) = 0;
     virtual Value visit(ExprArraySet* expr) = 0;
     virtual Value visit(ExprCall* expr) = 0;
+    virtual Value visit(ExprSpawn* expr) = 0;
 };
 
 class StmtVisitor
@@ -27,4 +28,6 @@ public:
     virtual void visit(StmtWhile* stmt) = 0;
     virtual void visit(StmtReturn* stmt) = 0;
     virtual void visit(StmtClass* stmt) = 0;
+    virtual void visit(StmtYield* stmt) = 0;
+    virtual void visit(StmtForIn* stmt) = 0;
 };
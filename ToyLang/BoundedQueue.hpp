@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Bounded multi producer multi consumer queue without locks. Every cell carries a sequence number
+// telling producers and consumers whose turn it is, so each side only contends on its own index.
+template<typename T>
+class BoundedQueue
+{
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+	alignas(64) std::atomic<size_t> enqueuePos;
+	alignas(64) std::atomic<size_t> dequeuePos;
+
+	// Spins briefly, then yields, then sleeps while the other side catches up.
+	static void pause(int spins)
+	{
+		if (spins < 16)
+			return;
+		if (spins < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+
+public:
+	// capacity is rounded up to a power of two.
+	explicit BoundedQueue(size_t capacity)
+		: enqueuePos(0), dequeuePos(0)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		cells.reset(new Cell[size]);
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	size_t capacity() const
+	{
+		return mask + 1;
+	}
+
+	// Moves value in unless the queue is full.
+	bool tryPush(T& value)
+	{
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[pos & mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.data = std::move(value);
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	bool tryPop(T& value)
+	{
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[pos & mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					value = std::move(cell.data);
+					cell.data = T();
+					cell.sequence.store(pos + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = dequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Blocks while the queue is full.
+	void push(T value)
+	{
+		for (int spins = 0; !tryPush(value); spins++)
+			pause(spins);
+	}
+
+	// Blocks while the queue is empty.
+	T pop()
+	{
+		T value;
+		for (int spins = 0; !tryPop(value); spins++)
+			pause(spins);
+		return value;
+	}
+};
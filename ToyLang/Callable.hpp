@@ -11,6 +11,7 @@ class Callable
 public:
 	virtual ~Callable() = default;
 	virtual Value call(Interpreter* interpreter, std::vector<Value> args) = 0;
+	// -1 accepts any argument count, the callable checks the arguments itself
 	virtual int arity() = 0;
 	virtual std::string name() = 0;
 };
@@ -26,13 +27,24 @@ public:
 
 	virtual Value call(Interpreter* interpreter, std::vector<Value> args) override
 	{
+		if (func->lazy)
+			interpreter->parseBody(func);
+
 		Enviroment* env = interpreter->enviroment;
 		interpreter->enviroment = new Enviroment(interpreter->globals);
+		// Tasks share the globals but report on their own output.
+		interpreter->enviroment->output = interpreter->output;
 		interpreter->enviroment->define("self", self);
 		for (size_t i = 0; i < args.size(); i++)
 		{
 			interpreter->enviroment->define(func->params[i], args[i]);
 		}
+		if (func->generator)
+		{
+			Value gen = interpreter->startGenerator(func, interpreter->enviroment);
+			interpreter->enviroment = env;
+			return gen;
+		}
 
 		Value ret;
 		try
@@ -119,6 +119,14 @@ public:
 		return Value();
 	}
 
+	Value visit(ExprSpawn* expr) override
+	{
+		std::cout << "(spawn ";
+		expr->call->accept(this);
+		std::cout << ")";
+		return Value();
+	}
+
 	void visit(StmtExpr* stmt) override
 	{
 		stmt->expr->accept(this);
@@ -197,4 +205,20 @@ public:
 			mem->accept(this);
 		std::cout << "ENDCLASS\n";
 	}
+
+	void visit(StmtYield* stmt) override
+	{
+		std::cout << "YIELD: ";
+		stmt->expr->accept(this);
+		std::cout << "\n";
+	}
+
+	void visit(StmtForIn* stmt) override
+	{
+		std::cout << "FOR: " << stmt->name.getLexeme() << " IN: ";
+		stmt->iterable->accept(this);
+		std::cout << "\nTHEN:\n";
+		stmt->body->accept(this);
+		std::cout << "ENDFOR\n";
+	}
 };
\ No newline at end of file
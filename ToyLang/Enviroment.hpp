@@ -3,17 +3,26 @@
 
 #include "Value.h"
 #include "Scanner.h"
+#include "Output.h"
 
 class Enviroment
 {
 public:
 	Enviroment* closing;
 	std::unordered_map<std::string, Value> vars;
+	// Where lookup errors go, inherited from the enclosing scope so each interpreter reports on its own output.
+	Output* output;
 	
 	Enviroment(Enviroment* closing = nullptr)
-		: closing(closing)
+		: closing(closing), output(closing ? closing->output : &Output::standard())
 	{ }
 
+	void report(const std::string& message)
+	{
+		output->write(message);
+		output->flush();
+	}
+
 	void define(Token name, Value val = Value())
 	{
 		std::string sName = name.getLexeme();
@@ -21,7 +30,9 @@ public:
 		if (it == vars.end())
 			vars[sName] = val;
 		else
-			std::cout << "[Error] Variable '" << name.getLexeme() << "' is a duplicate definition, line: " << name.line << std::endl;
+		{
+			report("[Error] Variable '" + sName + "' is a duplicate definition, line: " + std::to_string(name.line) + "\n");
+		}
 	}
 
 	void define(std::string name, Value val = Value())
@@ -30,7 +41,9 @@ public:
 		if (it == vars.end())
 			vars[name] = val;
 		else
-			std::cout << "[Error] Variable '" << name << "' is a duplicate definition"<< std::endl;
+		{
+			report("[Error] Variable '" + name + "' is a duplicate definition\n");
+		}
 	}
 
 	Value getVar(std::string name)
@@ -44,7 +57,7 @@ public:
 			else
 				return it->second;
 		}
-		std::cout << "[Error] Variable '" << name << "' does not exists." << std::endl;
+		report("[Error] Variable '" + name + "' does not exists.\n");
 		return Value();
 	}
 
@@ -59,7 +72,7 @@ public:
 			else
 				return it->second = set; // TODO OK?
 		}
-		std::cout << "[Error] Variable '" << name << "' does not exists." << std::endl;
+		report("[Error] Variable '" + name + "' does not exists.\n");
 		return Value();
 	}
 };
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "Generator.h"
+#include "Enviroment.hpp"
+#include "Interpreter.h"
+
+Generator::Generator(StmtFunction* func, Enviroment* locals)
+	: func(func), locals(locals), interpreter(nullptr), hasYielded(false), running(false)
+{
+	Frame body{ nullptr, &func->stmts, 0, locals, false, Value(), 0, false };
+	frames.push_back(body);
+}
+
+Generator::~Generator()
+{
+	while (!frames.empty())
+		pop();
+	delete locals;
+}
+
+void Generator::forEachValue(const std::function<void(const Value&)>& fn)
+{
+	for (auto& var : locals->vars)
+		fn(var.second);
+	for (auto& frame : frames)
+	{
+		if (frame.ownsScope)
+		{
+			for (auto& var : frame.scope->vars)
+				fn(var.second);
+		}
+		fn(frame.iterable);
+	}
+	fn(yielded);
+}
+
+void Generator::push(Stmt* stmt, Enviroment* scope, bool ownsScope)
+{
+	Frame frame{ stmt, nullptr, 0, scope, ownsScope, Value(), 0, false };
+	frames.push_back(frame);
+}
+
+void Generator::pop()
+{
+	if (frames.back().ownsScope)
+		delete frames.back().scope;
+	frames.pop_back();
+}
+
+bool Generator::resume(Interpreter* interpreter, Value& out)
+{
+	if (frames.empty())
+		return false;
+	if (running)
+		throw std::string("[ERROR] Generator '" + func->name.getLexeme() + "' resumed while it is running.\n");
+
+	Enviroment* env = interpreter->enviroment;
+	this->interpreter = interpreter;
+	running = true;
+	hasYielded = false;
+	try
+	{
+		while (!frames.empty() && !hasYielded)
+			step();
+	}
+	catch (...)
+	{
+		// A generator that failed does not continue.
+		while (!frames.empty())
+			pop();
+		interpreter->enviroment = env;
+		running = false;
+		throw;
+	}
+	interpreter->enviroment = env;
+	running = false;
+
+	if (!hasYielded)
+		return false;
+	out = std::move(yielded);
+	yielded = Value();
+	return true;
+}
+
+void Generator::step()
+{
+	Frame& top = frames.back();
+	interpreter->enviroment = top.scope;
+	if (!top.list)
+	{
+		top.stmt->accept(this);
+		return;
+	}
+
+	if (top.index < top.list->size())
+	{
+		Stmt* next = (*top.list)[top.index++].get();
+		push(next, top.scope, false);
+	}
+	else
+		pop();
+}
+
+bool Generator::condition(Expr* cond, Token& paren)
+{
+	Value res = cond->accept(interpreter);
+	if (res.tag != TypeTag::BOOL)
+		throw "Invalid data type for if statement at line: " + std::to_string(paren.line) + "\n";
+	return std::get<bool>(res.data);
+}
+
+void Generator::visit(StmtExpr* stmt)
+{
+	interpreter->visit(stmt);
+	pop();
+}
+
+void Generator::visit(StmtFunction* stmt)
+{
+	interpreter->visit(stmt);
+	pop();
+}
+
+void Generator::visit(StmtVarDecl* stmt)
+{
+	interpreter->visit(stmt);
+	pop();
+}
+
+void Generator::visit(StmtClass* stmt)
+{
+	interpreter->visit(stmt);
+	pop();
+}
+
+void Generator::visit(StmtBlock* stmt)
+{
+	// The frame turns into a list frame with a scope of its own.
+	Frame& top = frames.back();
+	top.list = &stmt->stmts;
+	top.scope = new Enviroment(top.scope);
+	top.ownsScope = true;
+}
+
+void Generator::visit(StmtIf* stmt)
+{
+	Frame& top = frames.back();
+	if (top.index != 0)
+	{
+		pop();
+		return;
+	}
+
+	top.index = 1;
+	Enviroment* scope = top.scope;
+	if (condition(stmt->cond.get(), stmt->paren))
+		push(stmt->then.get(), scope, false);
+	else if (stmt->els)
+		push(stmt->els.get(), scope, false);
+	else
+		pop();
+}
+
+void Generator::visit(StmtWhile* stmt)
+{
+	// The frame stays below its body and checks the condition again when the body is done.
+	Enviroment* scope = frames.back().scope;
+	if (condition(stmt->cond.get(), stmt->paren))
+		push(stmt->then.get(), scope, false);
+	else
+		pop();
+}
+
+void Generator::visit(StmtForIn* stmt)
+{
+	Frame& top = frames.back();
+	if (!top.started)
+	{
+		top.iterable = stmt->iterable->accept(interpreter);
+		top.started = true;
+	}
+
+	Value item;
+	if (!interpreter->iterate(top.iterable, top.position, item, stmt->name))
+	{
+		pop();
+		return;
+	}
+	Enviroment* scope = new Enviroment(top.scope);
+	scope->define(stmt->name, item);
+	push(stmt->body.get(), scope, true);
+}
+
+void Generator::visit(StmtYield* stmt)
+{
+	yielded = stmt->expr->accept(interpreter);
+	hasYielded = true;
+	pop();
+}
+
+void Generator::visit(StmtReturn* stmt)
+{
+	// return ends the generator, its value is not produced.
+	stmt->expr->accept(interpreter);
+	while (!frames.empty())
+		pop();
+}
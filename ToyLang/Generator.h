@@ -0,0 +1,67 @@
+#pragma once
+#include "AstVisitor.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Enviroment;
+class Interpreter;
+
+// Suspended run of a generator function. Its body is walked over an explicit stack of heap
+// allocated frames instead of the C++ stack, so the walk can stop at a yield and continue from
+// there on the next resume(). Expressions and simple statements still run on the Interpreter.
+class Generator : public StmtVisitor
+{
+private:
+	struct Frame
+	{
+		Stmt* stmt;
+		// Set for blocks and the function body, index is the next statement to run.
+		const std::vector<std::unique_ptr<Stmt>>* list;
+		size_t index;
+		Enviroment* scope;
+		bool ownsScope;
+		// State of a for in loop.
+		Value iterable;
+		size_t position;
+		bool started;
+	};
+
+	StmtFunction* func;
+	Enviroment* locals;
+	std::vector<Frame> frames;
+	Interpreter* interpreter;
+	Value yielded;
+	bool hasYielded;
+	bool running;
+
+	void push(Stmt* stmt, Enviroment* scope, bool ownsScope);
+	void pop();
+	void step();
+	bool condition(Expr* cond, Token& paren);
+
+public:
+	// Takes ownership of locals, the scope holding the parameters of the call.
+	Generator(StmtFunction* func, Enviroment* locals);
+	~Generator();
+	Generator(const Generator&) = delete;
+	Generator& operator=(const Generator&) = delete;
+
+	// Runs the body up to its next yield and stores the value in out. Returns false once the body
+	// has finished, from then on it keeps returning false.
+	bool resume(Interpreter* interpreter, Value& out);
+	// Calls fn with every value held by the suspended body: its variables and the loops it is in.
+	void forEachValue(const std::function<void(const Value&)>& fn);
+
+	void visit(StmtExpr* stmt) override;
+	void visit(StmtFunction* stmt) override;
+	void visit(StmtVarDecl* stmt) override;
+	void visit(StmtBlock* stmt) override;
+	void visit(StmtIf* stmt) override;
+	void visit(StmtWhile* stmt) override;
+	void visit(StmtReturn* stmt) override;
+	void visit(StmtClass* stmt) override;
+	void visit(StmtYield* stmt) override;
+	void visit(StmtForIn* stmt) override;
+};
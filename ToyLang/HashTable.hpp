@@ -0,0 +1,168 @@
+#pragma once
+#include "Value.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+inline uint64_t hashMix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+// Numbers and strings hash by value, callables and instances by identity.
+inline uint64_t hashValue(const Value& val)
+{
+	switch (val.tag)
+	{
+	case TypeTag::BOOL:
+		return hashMix(std::get<bool>(val.data) ? 1 : 2);
+	case TypeTag::NUMBER:
+	{
+		double num = std::get<double>(val.data);
+		if (num == 0)
+			num = 0; // -0 and 0 are the same key
+		uint64_t bits;
+		memcpy(&bits, &num, sizeof(bits));
+		return hashMix(bits);
+	}
+	case TypeTag::STRING:
+		return std::hash<std::string_view>()(std::get<std::string>(val.data));
+	case TypeTag::CALLABLE:
+		return hashMix((uint64_t)(uintptr_t)std::get<std::shared_ptr<Callable>>(val.data).get());
+	case TypeTag::INSTANCE:
+		return hashMix((uint64_t)(uintptr_t)std::get<std::shared_ptr<ToyInstance>>(val.data).get());
+	default:
+		return 0;
+	}
+}
+
+// Open addressing table with Robin Hood probing and backward shift deletion, keyed by Value.
+template<typename T>
+class HashTable
+{
+public:
+	struct Slot
+	{
+		Value key;
+		T value;
+		uint32_t hash;
+		uint32_t dist; // probe distance + 1, 0 marks an empty slot
+	};
+
+	HashTable()
+		: count(0)
+	{}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	T* find(const Value& key)
+	{
+		size_t i = findIndex(key);
+		return i == npos ? nullptr : &slots[i].value;
+	}
+
+	// Returns the value for key, inserting a default constructed one if it is missing.
+	T& insert(const Value& key)
+	{
+		if (T* found = find(key))
+			return *found;
+		if ((count + 1) * 8 > slots.size() * 7)
+			grow();
+
+		Slot slot{ key, T(), (uint32_t)hashValue(key), 1 };
+		size_t mask = slots.size() - 1;
+		size_t i = slot.hash & mask;
+		T* placed = nullptr;
+		for (; ; i = (i + 1) & mask)
+		{
+			if (slots[i].dist == 0)
+			{
+				slots[i] = std::move(slot);
+				count++;
+				return placed ? *placed : slots[i].value;
+			}
+			if (slots[i].dist < slot.dist)
+			{
+				std::swap(slots[i], slot);
+				if (!placed)
+					placed = &slots[i].value;
+			}
+			slot.dist++;
+		}
+	}
+
+	bool remove(const Value& key)
+	{
+		size_t i = findIndex(key);
+		if (i == npos)
+			return false;
+
+		size_t mask = slots.size() - 1;
+		size_t next = (i + 1) & mask;
+		while (slots[next].dist > 1)
+		{
+			slots[i] = std::move(slots[next]);
+			slots[i].dist--;
+			i = next;
+			next = (next + 1) & mask;
+		}
+		slots[i] = Slot{ Value(), T(), 0, 0 };
+		count--;
+		return true;
+	}
+
+	template<typename F>
+	void forEach(F func)
+	{
+		for (Slot& slot : slots)
+		{
+			if (slot.dist != 0)
+				func(slot.key, slot.value);
+		}
+	}
+
+private:
+	static constexpr size_t npos = (size_t)-1;
+	std::vector<Slot> slots;
+	size_t count;
+
+	size_t findIndex(const Value& key)
+	{
+		if (count == 0)
+			return npos;
+		uint32_t hash = (uint32_t)hashValue(key);
+		size_t mask = slots.size() - 1;
+		size_t i = hash & mask;
+		for (uint32_t dist = 1; ; dist++, i = (i + 1) & mask)
+		{
+			Slot& slot = slots[i];
+			if (slot.dist < dist)
+				return npos;
+			if (slot.hash == hash && slot.key.data == key.data)
+				return i;
+		}
+	}
+
+	void grow()
+	{
+		std::vector<Slot> old = std::move(slots);
+		slots = std::vector<Slot>(old.empty() ? 8 : old.size() * 2);
+		count = 0;
+		for (Slot& slot : old)
+		{
+			if (slot.dist != 0)
+				insert(slot.key) = std::move(slot.value);
+		}
+	}
+};
@@ -1,11 +1,25 @@
 #include "Interpreter.h"
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 
 #include "Enviroment.hpp"
 #include "Callable.hpp"
 #include "ToyClass.h"
 #include "NativeArray.hpp"
+#include "NativeFile.hpp"
+#include "NativeFloat64Array.hpp"
+#include "NativeGenerator.hpp"
+#include "NativeIsolate.hpp"
+#include "NativeMap.hpp"
+#include "NativeMappedArray.hpp"
+#include "NativeQueue.hpp"
+#include "NativeTask.hpp"
 #include "NativeFuncs.hpp"
+#include "Output.h"
+#include "AstCache.h"
+#include "Parser.h"
+#include "Resolver.h"
 #include "Value.h"
 
 Value Interpreter::runtimeTypeError(Token errToken)
@@ -15,33 +29,374 @@ Value Interpreter::runtimeTypeError(Token errToken)
 	return Value();
 }
 
+thread_local Interpreter* Interpreter::current = nullptr;
+
+static std::atomic<uint64_t> nextContextId(1);
+
 Interpreter::Interpreter(std::vector<Stmt*> root)
-	:root(root), enviroment(nullptr), globals(nullptr)
+	:root(root), ownsGlobals(true), enviroment(nullptr), globals(nullptr), output(&Output::standard()), input(&std::cin), resolver(nullptr),
+	owner(this), taskClass(nullptr), generatorClass(nullptr), pendingTasks(0), pendingIsolates(0),
+	contextId(nextContextId++), taskEpoch(0)
 {}
 
-void Interpreter::run()
+Interpreter::Interpreter(Interpreter* owner, Output* output)
+	:ownsGlobals(false), enviroment(owner->globals), globals(owner->globals), output(output), input(owner->input), resolver(owner->resolver),
+	owner(owner), taskClass(owner->taskClass), generatorClass(owner->generatorClass), pendingTasks(0), pendingIsolates(0),
+	contextId(nextContextId++), taskEpoch(0)
+{}
+
+// Interpreters running the same script on other threads may reach the same lazy body at once.
+static std::mutex bodyLock;
+
+bool Interpreter::buildBody(StmtFunction* func, Resolver* resolver, std::ostream& errors)
+{
+	std::lock_guard<std::mutex> lock(bodyLock);
+	if (!func->lazy)
+		return true;
+	if (func->bodyFailed)
+		return false;
+
+	bool built = func->bodyPool ? AstCache::decodeBody(func) : Parser::parseBody(func, errors);
+	if (!built)
+	{
+		func->bodyFailed = true;
+		return false;
+	}
+	if (resolver)
+		resolver->resolveBody(func);
+	// Only now other threads may run it.
+	func->lazy = false;
+	return true;
+}
+
+std::string Interpreter::currentError()
 {
+	try
+	{
+		throw;
+	}
+	catch (const std::string& message)
+	{
+		return message;
+	}
+	catch (const std::exception& e)
+	{
+		return std::string("[ERROR] Internal error: ") + e.what() + "\n";
+	}
+	catch (...)
+	{
+		return "[ERROR] Internal error.\n";
+	}
+}
+
+void Interpreter::parseBody(StmtFunction* func)
+{
+	// Syntax errors go to this interpreter's output, in order with what the program printed.
+	std::ostringstream errors;
+	bool built = buildBody(func, resolver, errors);
+	output->write(errors.str());
+	if (!built)
+	{
+		err << "[ERROR] Syntax error in the body of '" << func->name.getLexeme() << "' at line: " << func->name.line << std::endl;
+		throw err.str();
+	}
+}
+
+Interpreter::~Interpreter()
+{
+	// A task does not finish before the tasks it spawned, they may read its objects.
+	waitForTasks();
+	if (ownsGlobals)
+		delete globals;
+}
+
+void Interpreter::waitForTasks()
+{
+	while (pendingTasks > 0 || pendingIsolates > 0)
+	{
+		if (!ThreadPool::shared().runPending())
+			std::this_thread::yield();
+	}
+}
+
+// Also follows bound methods to their object, calling them may read it.
+static void forEachReachable(const Value& val, const std::function<void(ToyInstance*)>& fn)
+{
+	if (val.tag == TypeTag::INSTANCE)
+		fn(std::get<std::shared_ptr<ToyInstance>>(val.data).get());
+	else if (val.tag == TypeTag::CALLABLE)
+	{
+		auto function = dynamic_cast<ToyFunction*>(std::get<std::shared_ptr<Callable>>(val.data).get());
+		if (function && function->self.tag == TypeTag::INSTANCE)
+			fn(std::get<std::shared_ptr<ToyInstance>>(function->self.data).get());
+	}
+}
+
+void Interpreter::checkWrite(const ToyInstance* instance)
+{
+	bool mine = instance->creator == contextId || (instance->creator == 0 && owner == this);
+	if (!mine)
+		throw "[ERROR] This " + instance->klass->name() + " belongs to another task and can not be changed by this one.\n";
+	if (instance->frozenBy == contextId && instance->frozenEpoch == taskEpoch && pendingTasks > 0)
+		throw "[ERROR] This " + instance->klass->name() + " can not be changed while tasks that may read it are running.\n";
+}
+
+void Interpreter::checkGlobalWrite(const std::string& name, Token& at)
+{
+	Enviroment* look = enviroment;
+	while (look && look->vars.find(name) == look->vars.end())
+		look = look->closing;
+	if (look != globals)
+		return;
+	if (owner != this)
+		err << "[ERROR] Tasks can not assign the global '" << name << "' at line: " << at.line << std::endl;
+	else
+		err << "[ERROR] The global '" << name << "' can not be assigned while tasks are running at line: " << at.line << std::endl;
+	throw err.str();
+}
+
+void Interpreter::freeze(const Value& val)
+{
+	// Objects of other contexts can not be changed from here, so neither can what they hold be
+	// changed to point at objects of this one.
+	std::vector<ToyInstance*> pending;
+	auto visit = [&](ToyInstance* instance) {
+		bool mine = instance->creator == contextId || (instance->creator == 0 && owner == this);
+		if (!mine || (instance->frozenBy == contextId && instance->frozenEpoch == taskEpoch))
+			return;
+		instance->frozenBy = contextId;
+		instance->frozenEpoch = taskEpoch;
+		pending.push_back(instance);
+	};
+	forEachReachable(val, visit);
+	while (!pending.empty())
+	{
+		ToyInstance* instance = pending.back();
+		pending.pop_back();
+		instance->forEachValue([&](const Value& child) { forEachReachable(child, visit); });
+	}
+}
+
+void Interpreter::beginTask(const std::vector<Value>& args)
+{
+	if (pendingTasks == 0)
+		taskEpoch++;
+	pendingTasks++;
+	for (auto& arg : args)
+		freeze(arg);
+	for (auto& global : globals->vars)
+		freeze(global.second);
+}
+
+void Interpreter::adopt(const Value& val, const std::vector<uint64_t>& from)
+{
+	// Objects of other contexts are left alone along with what they hold: those of this one or of
+	// tasks still running can not have been changed to point at what the finished ones created.
+	std::vector<ToyInstance*> pending;
+	auto visit = [&](ToyInstance* instance) {
+		if (std::find(from.begin(), from.end(), instance->creator) == from.end())
+			return;
+		instance->creator = contextId;
+		pending.push_back(instance);
+	};
+	forEachReachable(val, visit);
+	while (!pending.empty())
+	{
+		ToyInstance* instance = pending.back();
+		pending.pop_back();
+		instance->forEachValue([&](const Value& child) { forEachReachable(child, visit); });
+	}
+}
+
+void Interpreter::defineNatives()
+{
+	waitForTasks();
+	delete globals;
 	globals = new Enviroment();
+	globals->output = output;
 	enviroment = globals;
+	natives.clear();
+
+	auto native = [this](const std::string& name, Value val) {
+		natives[name] = val;
+		globals->define(name, val);
+	};
+	native("print", Value(std::make_shared<NativePrint>()));
+	native("println", Value(std::make_shared<NativePrintln>()));
+	native("flush", Value(std::make_shared<NativeFlush>()));
+	native("input", Value(std::make_shared<NativeInput>()));
+	native("clock", Value(std::make_shared<NativeClock>()));
+	native("str", Value(std::make_shared<NativeStr>()));
+	native("num", Value(std::make_shared<NativeNum>()));
+	native("now", Value(std::make_shared<NativeNow>()));
+	native("sqrt", Value(std::make_shared<NativeSqrt>()));
+	native("floor", Value(std::make_shared<NativeFloor>()));
+	native("abs", Value(std::make_shared<NativeAbs>()));
+	native("min", Value(std::make_shared<NativeMin>()));
+	native("max", Value(std::make_shared<NativeMax>()));
+	native("sin", Value(std::make_shared<NativeSin>()));
+	native("cos", Value(std::make_shared<NativeCos>()));
+	native("pow", Value(std::make_shared<NativePow>()));
+	std::shared_ptr<NativeArray> arrayClass = std::make_shared<NativeArray>();
+	native("Array", Value(std::shared_ptr<Callable>(arrayClass)));
+	native("Float64Array", Value(std::make_shared<NativeFloat64Array>()));
+	native("Map", Value(std::make_shared<NativeMap>(arrayClass.get())));
+	native("Set", Value(std::make_shared<NativeSet>(arrayClass.get())));
+	native("Deque", Value(std::make_shared<NativeDeque>()));
+	native("PriorityQueue", Value(std::make_shared<NativePriorityQueue>()));
+	native("File", Value(std::make_shared<NativeFile>()));
+	native("MappedArray", Value(std::make_shared<NativeMappedArray>()));
+	std::shared_ptr<NativeTask> task = std::make_shared<NativeTask>();
+	taskClass = task.get();
+	native("Task", Value(std::shared_ptr<Callable>(task)));
+	native("join", Value(std::make_shared<NativeJoin>()));
+	native("parallelFor", Value(std::make_shared<NativeParallelFor>()));
+	native("Channel", Value(std::make_shared<NativeChannel>()));
+	std::shared_ptr<NativeGenerator> generator = std::make_shared<NativeGenerator>();
+	generatorClass = generator.get();
+	native("Generator", Value(std::shared_ptr<Callable>(generator)));
+	native("isolate", Value(std::make_shared<NativeIsolate>()));
 
-	enviroment->define("print", Value(std::make_shared<NativePrint>()));
-	enviroment->define("input", Value(std::make_shared<NativeInput>()));
-	enviroment->define("clock", Value(std::make_shared<NativeClock>()));
-	enviroment->define("str", Value(std::make_shared<NativeStr>()));
-	enviroment->define("Array", Value(std::make_shared<NativeArray>()));
+	std::shared_ptr<NativeArray::ArrayInstance> argArray = std::make_shared<NativeArray::ArrayInstance>(arrayClass.get());
+	for (auto& arg : args)
+		argArray->vec.push_back(Value(arg));
+	native("args", Value(std::shared_ptr<ToyInstance>(argArray)));
+}
 
+bool Interpreter::guarded(const std::function<void()>& body)
+{
+	bool ok = true;
+	err.str("");
+	error.clear();
+	Running running(this);
 	try
 	{
+		body();
+	}
+	catch (...)
+	{
+		error = currentError();
+		output->write(error);
+		ok = false;
+	}
+	output->flush();
+	return ok;
+}
+
+bool Interpreter::prepare(bool runInit)
+{
+	defineNatives();
+	return guarded([this, runInit]() {
 		for (auto& stmt : root)
 			stmt->accept(this);
+		if (!runInit)
+			return;
+
+		auto init = globals->vars.find("init");
+		if (init != globals->vars.end() && init->second.tag == TypeTag::CALLABLE)
+			std::get<std::shared_ptr<Callable>>(init->second.data)->call(this, {});
+	});
+}
+
+bool Interpreter::runMain()
+{
+	return guarded([this]() {
 		std::get<std::shared_ptr<Callable>>(enviroment->getVar("main").data)->call(this, {});
-	}
-	catch (std::string err)
+	});
+}
+
+std::unique_ptr<Interpreter> Interpreter::isolate(Output* output)
+{
+	std::unique_ptr<Interpreter> heap = std::make_unique<Interpreter>(root);
+	heap->resolver = resolver;
+	heap->output = output;
+	heap->input = input;
+	heap->args = args;
+	return heap;
+}
+
+Value Interpreter::startGenerator(StmtFunction* func, Enviroment* locals)
+{
+	return generatorClass->start(func, locals);
+}
+
+bool Interpreter::iterate(Value& iterable, size_t& position, Value& item, Token& at)
+{
+	if (iterable.tag == TypeTag::INSTANCE)
 	{
-		std::cout << err;
+		ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(iterable.data).get();
+		if (auto gen = dynamic_cast<NativeGenerator::GeneratorInstance*>(instance))
+		{
+			checkWrite(gen);
+			return gen->advance(this, item);
+		}
+		if (auto arr = dynamic_cast<NativeArray::ArrayInstance*>(instance))
+		{
+			if (position >= arr->vec.size())
+				return false;
+			item = arr->vec[position++];
+			return true;
+		}
+		if (auto arr = dynamic_cast<NativeFloat64Array::Float64ArrayInstance*>(instance))
+		{
+			if (position >= arr->vec.size())
+				return false;
+			item = arr->vec[position++];
+			return true;
+		}
+
+		Value hasNext = instance->get(iterable, "hasNext");
+		Value next = instance->get(iterable, "next");
+		if (hasNext.tag == TypeTag::CALLABLE && next.tag == TypeTag::CALLABLE)
+		{
+			Value more = std::get<std::shared_ptr<Callable>>(hasNext.data)->call(this, {});
+			if (more.tag != TypeTag::BOOL)
+			{
+				err << "[ERROR] hasNext() must return a bool at line: " << at.line << std::endl;
+				throw err.str();
+			}
+			if (!std::get<bool>(more.data))
+				return false;
+			item = std::get<std::shared_ptr<Callable>>(next.data)->call(this, {});
+			return true;
+		}
 	}
 
+	err << "[ERROR] Value is not iterable in 'for (" << at.getLexeme() << " in ...)' at line: " << at.line << std::endl;
+	throw err.str();
+}
+
+bool Interpreter::call(const std::string& name, const std::vector<Value>& args, Value& result)
+{
+	return guarded([&]() {
+		Callable* callable = nullptr;
+		if (globals)
+		{
+			auto it = globals->vars.find(name);
+			if (it != globals->vars.end() && it->second.tag == TypeTag::CALLABLE)
+				callable = std::get<std::shared_ptr<Callable>>(it->second.data).get();
+		}
+		if (!callable)
+		{
+			err << "[ERROR] There is no global function '" << name << "'.\n";
+			throw err.str();
+		}
+		if (callable->arity() != -1 && callable->arity() != (int)args.size())
+		{
+			err << "[ERROR] Invalid function call with invalid argument count\n";
+			throw err.str();
+		}
+		result = callable->call(this, args);
+	});
+}
+
+bool Interpreter::run()
+{
+	bool ok = prepare() && runMain();
+	waitForTasks();
 	delete globals;
+	globals = nullptr;
+	return ok;
 }
 
 Value Interpreter::visit(ExprBinary* expr)
@@ -292,6 +647,8 @@ Value Interpreter::visit(ExprVariableSet* expr)
 			return runtimeTypeError(expr->op);
 		}
 	}
+	if (owner != this || pendingTasks > 0)
+		checkGlobalWrite(name, expr->name);
 	enviroment->setVar(name, val);
 	return val;
 }
@@ -331,6 +688,7 @@ Value Interpreter::visit(ExprMemberSet* expr)
 		if (expr->op.type == TokenType::EQUAL)
 		{
 			Value val = expr->val->accept(this);
+			checkWrite(std::get<std::shared_ptr<ToyInstance>>(object.data).get());
 			std::get<std::shared_ptr<ToyInstance>>(object.data)->set(name, val);
 			return val;
 		}
@@ -412,7 +770,8 @@ Value Interpreter::visit(ExprMemberSet* expr)
 						return runtimeTypeError(expr->op);
 					}
 				}
-				std::get<std::shared_ptr<ToyInstance>>(object.data)->set(name, val);
+				checkWrite(instance.get());
+				instance->set(name, val);
 				return val;
 			}
 			else
@@ -431,22 +790,61 @@ Value Interpreter::visit(ExprMemberSet* expr)
 	}
 }
 
+Value Interpreter::indexGet(Value& obj, Value& index, Token& paren)
+{
+	ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(obj.data).get();
+	Value result;
+	if (instance->getIndex(index, result))
+		return result;
+
+	Value method = instance->get(obj, "__iget__");
+	if (method.tag != TypeTag::CALLABLE)
+	{
+		err << "[ERROR] Type " << instance->klass->name() << " does not have '__iget__' method at line: " << paren.line << std::endl;
+		throw err.str();
+	}
+	Callable* callable = std::get<std::shared_ptr<Callable>>(method.data).get();
+	if (callable->arity() == 1)
+		return callable->call(this, { index });
+	else
+	{
+		err << "[ERROR] Invalid function call with invalid argument count at line: " << paren.line << std::endl;
+		throw err.str();
+		return Value();
+	}
+}
+
+Value Interpreter::indexSet(Value& obj, Value& index, Value& val, Token& paren)
+{
+	ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(obj.data).get();
+	checkWrite(instance);
+	if (instance->setIndex(index, val))
+		return val;
+
+	Value method = instance->get(obj, "__iset__");
+	if (method.tag != TypeTag::CALLABLE)
+	{
+		err << "[ERROR] Type " << instance->klass->name() << " does not have '__iset__' method at line: " << paren.line << std::endl;
+		throw err.str();
+	}
+	Callable* callable = std::get<std::shared_ptr<Callable>>(method.data).get();
+	if (callable->arity() == 2)
+		return callable->call(this, { index, val });
+	else
+	{
+		err << "[ERROR] Invalid function call with invalid argument count at line: " << paren.line << std::endl;
+		throw err.str();
+		return Value();
+	}
+}
+
 Value Interpreter::visit(ExprArrayGet* expr)
 {
 	Value obj = expr->object->accept(this);
 	if (obj.tag == TypeTag::INSTANCE)
 	{
 		Value index = expr->index->accept(this);
-		Value method = std::get<std::shared_ptr<ToyInstance>>(obj.data)->get(obj, "__iget__");
-		Callable* callable = std::get<std::shared_ptr<Callable>>(method.data).get();
-		if (callable->arity() == 1)
-			return callable->call(this, { index });
-		else
-		{
-			err << "[ERROR] Invalid function call with invalid argument count at line: " << expr->paren.line << std::endl;
-			throw err.str();
-			return Value();
-		}
+		return indexGet(obj, index, expr->paren);
 	}
 	else
 	{
@@ -461,107 +859,85 @@ Value Interpreter::visit(ExprArraySet* expr)
 	Value obj = expr->object->accept(this);
 	if (obj.tag == TypeTag::INSTANCE)
 	{
-			Value index = expr->index->accept(this);
-			Value val = expr->val->accept(this);
-			Value set_method = std::get<std::shared_ptr<ToyInstance>>(obj.data)->get(obj, "__iset__");
-			Callable* set_callable = std::get<std::shared_ptr<Callable>>(set_method.data).get();
-			if (set_callable->arity() == 2)
-			{
-				if (expr->op.type != TokenType::EQUAL)
+		Value index = expr->index->accept(this);
+		Value val = expr->val->accept(this);
+		if (expr->op.type != TokenType::EQUAL)
+		{
+			auto callMethod = [this](Value& a, Value& b, const std::string& name) {
+				Value func = std::get<std::shared_ptr<ToyInstance>>(a.data)->get(a, name);
+				Callable* callable = std::get<std::shared_ptr<Callable>>(func.data).get();
+				if (func.tag == TypeTag::CALLABLE)
 				{
-					auto callMethod = [this](Value& a, Value& b, const std::string& name) {
-						Value func = std::get<std::shared_ptr<ToyInstance>>(a.data)->get(a, name);
-						Callable* callable = std::get<std::shared_ptr<Callable>>(func.data).get();
-						if (func.tag == TypeTag::CALLABLE)
-						{
-							if (callable->arity() == 1)
-								return callable->call(this, { b });
-							else
-							{
-								err << "[ERROR] Invalid function call with invalid argument count\n";
-								throw err.str();
-								return Value();
-							}
-						}
-						else
-						{
-							err << "[ERROR] Type " << std::get<std::shared_ptr<ToyInstance>>(a.data)->klass->name() << " does not have '" << name << "' method.\n";
-							throw err.str();
-							return Value();
-						}
-					};
-
-					Value method = std::get<std::shared_ptr<ToyInstance>>(obj.data)->get(obj, "__iget__");
-					Callable* callable = std::get<std::shared_ptr<Callable>>(method.data).get();
-					Value getted;
 					if (callable->arity() == 1)
-						getted = callable->call(this, { index });
+						return callable->call(this, { b });
 					else
 					{
-						err << "[ERROR] Invalid function call with invalid argument count at line: " << expr->paren.line << std::endl;
+						err << "[ERROR] Invalid function call with invalid argument count\n";
 						throw err.str();
 						return Value();
 					}
-
-					if (getted.tag == TypeTag::INSTANCE)
-					{
-						switch (expr->op.type)
-						{
-						case TokenType::PLUS_EQUAL:
-							val = callMethod(getted, val, "__iadd__");
-							break;
-						case TokenType::MINUS_EQUAL:
-							val = callMethod(getted, val, "__isub__");
-							break;
-						case TokenType::STAR_EQUAL:
-							val = callMethod(getted, val, "__imul__");
-							break;
-						case TokenType::SLASH_EQUAL:
-							val = callMethod(getted, val, "__idiv__");
-							break;
-						}
-					}
-					else if (getted.tag != TypeTag::ERR)
-					{
-						if (val.tag == TypeTag::NUMBER && getted.tag == TypeTag::NUMBER)
-						{
-							switch (expr->op.type)
-							{
-							case TokenType::PLUS_EQUAL:
-								val.data = std::get<double>(getted.data) + std::get<double>(val.data);
-								break;
-							case TokenType::MINUS_EQUAL:
-								val.data = std::get<double>(getted.data) - std::get<double>(val.data);
-								break;
-							case TokenType::STAR_EQUAL:
-								val.data = std::get<double>(getted.data) * std::get<double>(val.data);
-								break;
-							case TokenType::SLASH_EQUAL:
-								val.data = std::get<double>(getted.data) / std::get<double>(val.data);
-								break;
-							}
-						}
-						else if (val.tag == TypeTag::STRING && getted.tag == TypeTag::STRING)
-						{
-							std::stringstream ss;
-							ss << std::get<std::string>(getted.data) << std::get<std::string>(val.data);
-							val.data = ss.str().c_str();
-						}
-						else
-						{
-							return runtimeTypeError(expr->op);
-						}
-					}
 				}
+				else
+				{
+					err << "[ERROR] Type " << std::get<std::shared_ptr<ToyInstance>>(a.data)->klass->name() << " does not have '" << name << "' method.\n";
+					throw err.str();
+					return Value();
+				}
+			};
 
-				return set_callable->call(this, { index, val });
+			Value getted = indexGet(obj, index, expr->paren);
+			if (getted.tag == TypeTag::INSTANCE)
+			{
+				switch (expr->op.type)
+				{
+				case TokenType::PLUS_EQUAL:
+					val = callMethod(getted, val, "__iadd__");
+					break;
+				case TokenType::MINUS_EQUAL:
+					val = callMethod(getted, val, "__isub__");
+					break;
+				case TokenType::STAR_EQUAL:
+					val = callMethod(getted, val, "__imul__");
+					break;
+				case TokenType::SLASH_EQUAL:
+					val = callMethod(getted, val, "__idiv__");
+					break;
+				}
 			}
-			else
+			else if (getted.tag != TypeTag::ERR)
 			{
-				err << "[ERROR] Invalid function call with invalid argument count at line: " << expr->paren.line << std::endl;
-				throw err.str();
-				return Value();
+				if (val.tag == TypeTag::NUMBER && getted.tag == TypeTag::NUMBER)
+				{
+					switch (expr->op.type)
+					{
+					case TokenType::PLUS_EQUAL:
+						val.data = std::get<double>(getted.data) + std::get<double>(val.data);
+						break;
+					case TokenType::MINUS_EQUAL:
+						val.data = std::get<double>(getted.data) - std::get<double>(val.data);
+						break;
+					case TokenType::STAR_EQUAL:
+						val.data = std::get<double>(getted.data) * std::get<double>(val.data);
+						break;
+					case TokenType::SLASH_EQUAL:
+						val.data = std::get<double>(getted.data) / std::get<double>(val.data);
+						break;
+					}
+				}
+				else if (val.tag == TypeTag::STRING && getted.tag == TypeTag::STRING)
+				{
+					std::stringstream ss;
+					ss << std::get<std::string>(getted.data) << std::get<std::string>(val.data);
+					val.data = ss.str().c_str();
+				}
+				else
+				{
+					return runtimeTypeError(expr->op);
+				}
 			}
+		}
+
+		return indexSet(obj, index, val, expr->paren);
 	}
 	else
 	{
@@ -572,8 +948,80 @@ Value Interpreter::visit(ExprArraySet* expr)
 }
 
 
+Value Interpreter::callIntrinsic(ExprCall* expr)
+{
+	auto number = [this, expr](size_t i) {
+		Value val = expr->args[i]->accept(this);
+		if (val.tag != TypeTag::NUMBER)
+		{
+			err << "[ERROR] Function '" << ((ExprVariableGet*)expr->callee.get())->name.getLexeme() << "' expects a number argument at line: " << expr->paren.line << std::endl;
+			throw err.str();
+		}
+		return std::get<double>(val.data);
+	};
+
+	switch (expr->intrinsic)
+	{
+	case Intrinsic::PRINT:
+		output->write(expr->args[0]->accept(this));
+		return Value();
+	case Intrinsic::PRINTLN:
+		output->write(expr->args[0]->accept(this));
+		output->write('\n');
+		return Value();
+	case Intrinsic::FLUSH:
+		output->flush();
+		return Value();
+	case Intrinsic::INPUT:
+	{
+		output->flush();
+		std::string line;
+		std::getline(*input, line);
+		return Value(line);
+	}
+	case Intrinsic::CLOCK:
+		return (double)clock() / CLOCKS_PER_SEC;
+	case Intrinsic::NOW:
+		return NativeNow::now();
+	case Intrinsic::STR:
+		return Value(expr->args[0]->accept(this).toString());
+	case Intrinsic::NUM:
+		return NativeNum::parse(expr->args[0]->accept(this));
+	case Intrinsic::SQRT:
+		return std::sqrt(number(0));
+	case Intrinsic::FLOOR:
+		return std::floor(number(0));
+	case Intrinsic::ABS:
+		return std::fabs(number(0));
+	case Intrinsic::SIN:
+		return std::sin(number(0));
+	case Intrinsic::COS:
+		return std::cos(number(0));
+	case Intrinsic::MIN:
+	{
+		double a = number(0);
+		return std::fmin(a, number(1));
+	}
+	case Intrinsic::MAX:
+	{
+		double a = number(0);
+		return std::fmax(a, number(1));
+	}
+	case Intrinsic::POW:
+	{
+		double a = number(0);
+		return std::pow(a, number(1));
+	}
+	default:
+		return Value();
+	}
+}
+
 Value Interpreter::visit(ExprCall* expr)
 {
+	if (expr->intrinsic != Intrinsic::NONE)
+		return callIntrinsic(expr);
+
 	Value func = expr->callee->accept(this);
 	if (func.tag != TypeTag::CALLABLE)
 	{
@@ -581,7 +1029,9 @@ Value Interpreter::visit(ExprCall* expr)
 		throw err.str();
 		return Value();
 	}
-	else if (std::get<std::shared_ptr<Callable>>(func.data)->arity() == expr->args.size())
+
+	int arity = std::get<std::shared_ptr<Callable>>(func.data)->arity();
+	if (arity == -1 || arity == (int)expr->args.size())
 	{
 		std::vector<Value> args;
 		for (auto& a : expr->args)
@@ -598,6 +1048,29 @@ Value Interpreter::visit(ExprCall* expr)
 	}
 }
 
+Value Interpreter::visit(ExprSpawn* expr)
+{
+	Value func = expr->call->callee->accept(this);
+	if (func.tag != TypeTag::CALLABLE)
+	{
+		err << "[ERROR] Invalid spawn of a value that is not callable at line: " << expr->keyword.line << std::endl;
+		throw err.str();
+	}
+
+	std::shared_ptr<Callable> callable = std::get<std::shared_ptr<Callable>>(func.data);
+	int arity = callable->arity();
+	if (arity != -1 && arity != (int)expr->call->args.size())
+	{
+		err << "[ERROR] Invalid function call with invalid argument count at line: " << expr->call->paren.line << std::endl;
+		throw err.str();
+	}
+
+	std::vector<Value> args;
+	for (auto& a : expr->call->args)
+		args.push_back(a->accept(this));
+	return taskClass->spawn(this, callable, args);
+}
+
 Value Interpreter::visit(ExprLiteral* expr)
 {
 	return expr->value;
@@ -609,18 +1082,34 @@ void Interpreter::visit(StmtExpr* stmt)
 	// std::cout << a << std::endl;
 }
 
+void Interpreter::declare(Token name, Value val)
+{
+	if (enviroment == globals)
+	{
+		std::string sName = name.getLexeme();
+		auto native = natives.find(sName);
+		auto it = globals->vars.find(sName);
+		if (native != natives.end() && it != globals->vars.end() && it->second.data == native->second.data)
+		{
+			it->second = val;
+			return;
+		}
+	}
+	enviroment->define(name, val);
+}
+
 void Interpreter::visit(StmtFunction* stmt)
 {
 	Value funcVal(std::make_shared<ToyFunction>(stmt));
-	enviroment->define(stmt->name, funcVal);
+	declare(stmt->name, funcVal);
 }
 
 void Interpreter::visit(StmtVarDecl* stmt)
 {
 	if (stmt->initVal.get())
-		enviroment->define(stmt->name, stmt->initVal->accept(this));
+		declare(stmt->name, stmt->initVal->accept(this));
 	else
-		enviroment->define(stmt->name);
+		declare(stmt->name, Value());
 }
 
 void Interpreter::visit(StmtBlock* stmt)
@@ -676,5 +1165,28 @@ void Interpreter::visit(StmtReturn* stmt)
 
 void Interpreter::visit(StmtClass* stmt)
 {
-	enviroment->define(stmt->name, Value(std::make_shared<ToyClass>(stmt->name.getLexeme(), stmt->methods)));
+	declare(stmt->name, Value(std::make_shared<ToyClass>(stmt->name.getLexeme(), stmt->methods)));
+}
+
+void Interpreter::visit(StmtYield* stmt)
+{
+	// Generator bodies are run by Generator, which handles yield itself.
+	err << "[ERROR] 'yield' outside of a generator at line: " << stmt->keyword.line << std::endl;
+	throw err.str();
+}
+
+void Interpreter::visit(StmtForIn* stmt)
+{
+	Value iterable = stmt->iterable->accept(this);
+	size_t position = 0;
+	Value item;
+	Enviroment* env = this->enviroment;
+	while (iterate(iterable, position, item, stmt->name))
+	{
+		this->enviroment = new Enviroment(env);
+		this->enviroment->define(stmt->name, item);
+		stmt->body->accept(this);
+		delete this->enviroment;
+		this->enviroment = env;
+	}
 }
@@ -1,21 +1,118 @@
 #pragma once
 #include "AstVisitor.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <sstream>
+#include <unordered_map>
 
 class Enviroment;
+class NativeGenerator;
+class NativeTask;
+class Output;
+class Resolver;
+class ToyInstance;
 
 class Interpreter : public ExprVisitor, public StmtVisitor
 {
 private:
 	Value runtimeTypeError(Token errToken);
+	Value callIntrinsic(ExprCall* expr);
+	Value indexGet(Value& obj, Value& index, Token& paren);
+	Value indexSet(Value& obj, Value& index, Value& val, Token& paren);
+	// Defines name in the current scope, a top level declaration replaces a native of the same name.
+	void declare(Token name, Value val);
 	std::vector<Stmt*> root;
 	std::stringstream err;
+	bool ownsGlobals;
+
+	// Lets spawned tasks finish before the globals they run in, or the objects they read, go away.
+	void waitForTasks();
+	// Throws if name resolves to a global while this is a task or has tasks running.
+	void checkGlobalWrite(const std::string& name, Token& at);
+
+	// Runs body and reports a runtime error it throws, returns false if it threw.
+	bool guarded(const std::function<void()>& body);
 public:
 	Enviroment* enviroment;
 	Enviroment* globals;
+	Output* output;
+	// Where input() reads lines from, std::cin unless the embedder sets another stream. Tasks and
+	// isolates read from the stream of the interpreter that started them.
+	std::istream* input;
+	// Binds intrinsics in bodies parsed on first call, may be null.
+	Resolver* resolver;
+	// The interpreter owning the globals, this one unless it runs a spawned task.
+	Interpreter* owner;
+	NativeTask* taskClass;
+	NativeGenerator* generatorClass;
+	// Tasks spawned from this interpreter that have not finished.
+	std::atomic<size_t> pendingTasks;
+	// Isolates started from this interpreter that have not finished, they only keep it alive.
+	std::atomic<size_t> pendingIsolates;
+
+	// Tasks share the heap of their owner without locks. An object may only be changed by the
+	// context that created it, and not while tasks that can reach it are running. Objects a task
+	// creates are handed to whoever joins it.
+	static thread_local Interpreter* current;
+	// Makes an interpreter the current one for as long as it is in scope.
+	class Running
+	{
+	private:
+		Interpreter* previous;
+	public:
+		Running(Interpreter* context) : previous(current) { current = context; }
+		~Running() { current = previous; }
+	};
+	// Unique among all interpreters, stamped on the objects created while this one is current.
+	uint64_t contextId;
+	// Counts the periods in which this context had tasks running, objects frozen in an earlier one are free again.
+	uint64_t taskEpoch;
+
+	// Native globals by name, as registered by defineNatives().
+	std::unordered_map<std::string, Value> natives;
+	// Command line arguments, visible to the script as the args array.
+	std::vector<std::string> args;
+	// Message of the runtime error that stopped the last run or call, empty if it finished.
+	std::string error;
 
 	Interpreter(std::vector<Stmt*> root);
-	void run();
+	// Context for a spawned task, with its own scopes and output over the globals of owner.
+	Interpreter(Interpreter* owner, Output* output);
+	~Interpreter();
+	// Runs prepare() and runMain() and releases the globals. Returns false if the program stopped on a runtime error.
+	bool run();
+	// Replaces the globals with fresh ones holding only the natives.
+	void defineNatives();
+	// Registers the natives and runs the top level declarations. With runInit set, as when writing a
+	// snapshot, init() runs afterwards if the script defines one.
+	bool prepare(bool runInit = false);
+	bool runMain();
+	// A new interpreter over the same program with globals of its own, for isolates.
+	std::unique_ptr<Interpreter> isolate(Output* output);
+	// Calls a global function after prepare(), result is left alone if it fails.
+	bool call(const std::string& name, const std::vector<Value>& args, Value& result);
+	// Wraps a call of a function that yields, locals holds its parameters and is owned by the generator.
+	Value startGenerator(StmtFunction* func, Enviroment* locals);
+	// Produces the next item of a for in loop over iterable, position is the loop's own counter.
+	// Returns false when the items are exhausted.
+	bool iterate(Value& iterable, size_t& position, Value& item, Token& at);
+	// Parses a body the parser skipped, called by ToyFunction before its first run.
+	void parseBody(StmtFunction* func);
+	// Parses or decodes a lazy body once and binds it with resolver, which may be null. Safe to call
+	// from several threads, syntax errors go to errors. Returns false if the body does not parse.
+	static bool buildBody(StmtFunction* func, Resolver* resolver, std::ostream& errors);
+	// Message for the exception being handled, for code that has to report every failure instead of
+	// letting it end the process: runtime errors are strings, anything else is an internal error.
+	static std::string currentError();
+	// Throws unless this context may change instance right now.
+	void checkWrite(const ToyInstance* instance);
+	// Called before spawning a task, freezes what it can reach from args and the globals.
+	void beginTask(const std::vector<Value>& args);
+	// Marks the objects of this context reachable from val as read by the running tasks.
+	void freeze(const Value& val);
+	// Takes over the objects reachable from val that were created by the finished contexts in from.
+	void adopt(const Value& val, const std::vector<uint64_t>& from);
 
 	Value visit(ExprBinary* expr);
 	Value visit(ExprUnary* expr);
@@ -27,6 +124,7 @@ public:
 	Value visit(ExprMemberSet* expr);
 	Value visit(ExprArrayGet* expr);
 	Value visit(ExprArraySet* expr);
+	Value visit(ExprSpawn* expr);
 
 	void visit(StmtExpr* stmt);
 	void visit(StmtFunction* stmt);
@@ -36,5 +134,7 @@ public:
 	void visit(StmtWhile* stmt);
 	void visit(StmtReturn* stmt);
 	void visit(StmtClass* stmt);
+	void visit(StmtYield* stmt);
+	void visit(StmtForIn* stmt);
 };
 
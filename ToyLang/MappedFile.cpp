@@ -0,0 +1,163 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+	: file(INVALID_HANDLE_VALUE), mapping(nullptr), ptr(nullptr), length(0)
+{}
+
+bool MappedFile::open(const std::string& path, bool writable)
+{
+	close();
+	file = CreateFileA(path.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0), FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	if (length == 0)
+		return true;
+
+	mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		close();
+		return false;
+	}
+	ptr = (char*)MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+	if (!ptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (ptr)
+		UnmapViewOfFile(ptr);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	file = INVALID_HANDLE_VALUE;
+	mapping = nullptr;
+	ptr = nullptr;
+	length = 0;
+}
+
+bool MappedFile::readAll(const std::string& path, std::string& out)
+{
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (GetFileType(handle) == FILE_TYPE_DISK && GetFileSizeEx(handle, &fileSize))
+		out.reserve((size_t)fileSize.QuadPart);
+	char chunk[1 << 16];
+	DWORD read;
+	bool ok = true;
+	while ((ok = ReadFile(handle, chunk, sizeof(chunk), &read, nullptr) != 0) && read > 0)
+		out.append(chunk, read);
+	// Reading a pipe ends with ERROR_BROKEN_PIPE once the writer closes it.
+	if (!ok && GetLastError() == ERROR_BROKEN_PIPE)
+		ok = true;
+	CloseHandle(handle);
+	return ok;
+}
+
+#else
+
+MappedFile::MappedFile()
+	: fd(-1), ptr(nullptr), length(0)
+{}
+
+bool MappedFile::open(const std::string& path, bool writable)
+{
+	close();
+	fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		close();
+		return false;
+	}
+	length = (size_t)st.st_size;
+	if (length == 0)
+		return true;
+
+	void* mapped = mmap(nullptr, length, PROT_READ | (writable ? PROT_WRITE : 0), writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	ptr = (char*)mapped;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (ptr)
+		munmap(ptr, length);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+	ptr = nullptr;
+	length = 0;
+}
+
+bool MappedFile::readAll(const std::string& path, std::string& out)
+{
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(file, &st) == 0 && S_ISREG(st.st_mode))
+		out.reserve((size_t)st.st_size);
+	char chunk[1 << 16];
+	ssize_t read;
+	while ((read = ::read(file, chunk, sizeof(chunk))) != 0)
+	{
+		if (read < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			::close(file);
+			return false;
+		}
+		out.append(chunk, (size_t)read);
+	}
+	::close(file);
+	return true;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Maps a whole file into memory, read only and private or shared read write.
+class MappedFile
+{
+private:
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int fd;
+#endif
+	char* ptr;
+	size_t length;
+
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path, bool writable = false);
+	void close();
+
+	// Reads the whole file into out through a single handle, for files that may change while they
+	// are in use and for pipes and devices, which can not be mapped or opened twice.
+	static bool readAll(const std::string& path, std::string& out);
+
+	char* data() const { return ptr; }
+	size_t size() const { return length; }
+};
@@ -1,5 +1,10 @@
 #pragma once
 #include "Callable.hpp"
+#include "NativeFuncs.hpp"
+#include "NativeParallel.hpp"
+
+#include <algorithm>
+#include <iterator>
 
 class NativeArray;
 
@@ -12,6 +17,34 @@ public:
 		std::vector<Value> vec;
 		ArrayInstance(NativeArray* klass)
 			: ToyInstance(klass) {}
+
+		size_t index(const Value& val)
+		{
+			if (val.tag != TypeTag::NUMBER)
+				throw std::string("[ERROR] Array index must be a number.\n");
+			double index = wholeArg(val, "Array index");
+			if (index < 0 || index >= vec.size())
+				throw "[ERROR] Array index " + val.toString() + " is out of range.\n";
+			return (size_t)index;
+		}
+
+		bool getIndex(const Value& index, Value& out) override
+		{
+			out = vec[this->index(index)];
+			return true;
+		}
+
+		bool setIndex(const Value& index, const Value& val) override
+		{
+			vec[this->index(index)] = val;
+			return true;
+		}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			for (auto& val : vec)
+				fn(val);
+		}
 	};
 
 	class MethodGet : public ToyFunction
@@ -23,8 +56,8 @@ public:
 
 		Value call(Interpreter* interpreter, std::vector<Value> args) override
 		{
-			size_t index = std::get<double>(args[0].data);
-			return ((ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get())->vec[index];
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return arr->vec[arr->index(args[0])];
 		}
 
 		int arity() override
@@ -55,8 +88,8 @@ public:
 
 		Value call(Interpreter* interpreter, std::vector<Value> args) override
 		{
-			size_t index = std::get<double>(args[0].data);
-			((ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get())->vec[index] = args[1];
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
+			arr->vec[arr->index(args[0])] = args[1];
 			return args[1];
 		}
 
@@ -87,7 +120,7 @@ public:
 
 		Value call(Interpreter* interpreter, std::vector<Value> args) override
 		{
-			((ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get())->vec.push_back(args[0]);
+			writableSelf<ArrayInstance>(interpreter, self)->vec.push_back(args[0]);
 			return Value();
 		}
 
@@ -118,7 +151,7 @@ public:
 
 		Value call(Interpreter* interpreter, std::vector<Value> args) override
 		{
-			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
 			Value back = arr->vec.back();
 			arr->vec.pop_back();
 			return back;
@@ -172,6 +205,472 @@ public:
 			return Value(method);
 		}
 	};
+
+	class MethodSort : public ToyFunction
+	{
+	public:
+		MethodSort()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
+			if (args.size() == 0)
+			{
+				if (std::all_of(arr->vec.begin(), arr->vec.end(), [](const Value& v) { return v.tag == TypeTag::NUMBER; }))
+					std::sort(arr->vec.begin(), arr->vec.end(), [](const Value& a, const Value& b) { return std::get<double>(a.data) < std::get<double>(b.data); });
+				else if (std::all_of(arr->vec.begin(), arr->vec.end(), [](const Value& v) { return v.tag == TypeTag::STRING; }))
+					std::sort(arr->vec.begin(), arr->vec.end(), [](const Value& a, const Value& b) { return std::get<std::string>(a.data) < std::get<std::string>(b.data); });
+				else
+					throw std::string("[ERROR] Array.sort without a comparator needs all numbers or all strings.\n");
+			}
+			else if (args.size() == 1 && args[0].tag == TypeTag::CALLABLE && std::get<std::shared_ptr<Callable>>(args[0].data)->arity() == 2)
+			{
+				Callable* cmp = std::get<std::shared_ptr<Callable>>(args[0].data).get();
+				std::stable_sort(arr->vec.begin(), arr->vec.end(), [interpreter, cmp](const Value& a, const Value& b) {
+					Value res = cmp->call(interpreter, { a, b });
+					if (res.tag != TypeTag::BOOL)
+						throw std::string("[ERROR] Array.sort comparator must return a bool.\n");
+					return std::get<bool>(res.data);
+				});
+			}
+			else
+			{
+				throw std::string("[ERROR] Array.sort expects no arguments or a comparator with 2 parameters.\n");
+			}
+			return self;
+		}
+
+		int arity() override
+		{
+			return -1;
+		}
+
+		std::string name() override
+		{
+			return "sort";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSort>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodFill : public ToyFunction
+	{
+	public:
+		MethodFill()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
+			std::fill(arr->vec.begin(), arr->vec.end(), args[0]);
+			return self;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "fill";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodFill>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSlice : public ToyFunction
+	{
+	public:
+		MethodSlice()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			double size = (double)arr->vec.size();
+			size_t begin = (size_t)std::clamp(wholeArg(args[0], "Array.slice"), 0.0, size);
+			size_t end = (size_t)std::clamp(wholeArg(args[1], "Array.slice"), 0.0, size);
+			std::shared_ptr<ArrayInstance> slice = std::make_shared<ArrayInstance>((NativeArray*)arr->klass);
+			if (begin < end)
+				slice->vec.assign(arr->vec.begin() + begin, arr->vec.begin() + end);
+			return Value(std::shared_ptr<ToyInstance>(slice));
+		}
+
+		int arity() override
+		{
+			return 2;
+		}
+
+		std::string name() override
+		{
+			return "slice";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSlice>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodReserve : public ToyFunction
+	{
+	public:
+		MethodReserve()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
+			double capacity = wholeArg(args[0], "Array.reserve");
+			if (capacity > MAX_WHOLE_ARG || capacity > arr->vec.max_size())
+				throw std::string("[ERROR] Array.reserve capacity is too large.\n");
+			arr->vec.reserve((size_t)std::max(capacity, 0.0));
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "reserve";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodReserve>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodIndexOf : public ToyFunction
+	{
+	public:
+		MethodIndexOf()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			for (size_t i = 0; i < arr->vec.size(); i++)
+			{
+				if (arr->vec[i].data == args[0].data)
+					return Value((double)i);
+			}
+			return Value(-1.0);
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "indexOf";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodIndexOf>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodReverse : public ToyFunction
+	{
+	public:
+		MethodReverse()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
+			std::reverse(arr->vec.begin(), arr->vec.end());
+			return self;
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "reverse";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodReverse>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodExtend : public ToyFunction
+	{
+	public:
+		MethodExtend()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = writableSelf<ArrayInstance>(interpreter, self);
+			ArrayInstance* other = nullptr;
+			if (args[0].tag == TypeTag::INSTANCE)
+				other = dynamic_cast<ArrayInstance*>(std::get<std::shared_ptr<ToyInstance>>(args[0].data).get());
+			if (!other)
+				throw std::string("[ERROR] Array.extend expects an Array argument.\n");
+			if (other == arr)
+			{
+				size_t size = arr->vec.size();
+				arr->vec.reserve(size * 2);
+				std::copy_n(arr->vec.begin(), size, std::back_inserter(arr->vec));
+			}
+			else
+				arr->vec.insert(arr->vec.end(), other->vec.begin(), other->vec.end());
+			return self;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "extend";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodExtend>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodJoin : public ToyFunction
+	{
+	public:
+		MethodJoin()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			if (args[0].tag != TypeTag::STRING)
+				throw std::string("[ERROR] Array.join expects a string separator.\n");
+			const std::string& sep = std::get<std::string>(args[0].data);
+			std::string joined;
+			for (size_t i = 0; i < arr->vec.size(); i++)
+			{
+				if (i > 0)
+					joined += sep;
+				if (arr->vec[i].tag == TypeTag::STRING)
+					joined += std::get<std::string>(arr->vec[i].data);
+				else
+					joined += arr->vec[i].toString();
+			}
+			return Value(joined);
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "join";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodJoin>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	// map and filter split large arrays across the pool, see parallelRange(). So does reduce given a combine function.
+	class MethodMap : public ToyFunction
+	{
+	public:
+		MethodMap()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Callable* fn = callbackArg(args[0], 1, "Array.map");
+			std::shared_ptr<ArrayInstance> mapped = std::make_shared<ArrayInstance>((NativeArray*)arr->klass);
+			// Every chunk writes its own slots of the presized result.
+			mapped->vec.resize(arr->vec.size());
+			std::vector<uint64_t> contexts = parallelRange(interpreter, arr->vec.size(), [&](Interpreter* context, size_t, size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					mapped->vec[i] = fn->call(context, { arr->vec[i] });
+			});
+			for (auto& val : mapped->vec)
+				interpreter->adopt(val, contexts);
+			return Value(std::shared_ptr<ToyInstance>(mapped));
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "map";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodMap>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodFilter : public ToyFunction
+	{
+	public:
+		MethodFilter()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Callable* fn = callbackArg(args[0], 1, "Array.filter");
+			std::vector<char> keep(arr->vec.size());
+			parallelRange(interpreter, arr->vec.size(), [&](Interpreter* context, size_t, size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+				{
+					Value res = fn->call(context, { arr->vec[i] });
+					if (res.tag != TypeTag::BOOL)
+						throw std::string("[ERROR] Array.filter predicate must return a bool.\n");
+					keep[i] = std::get<bool>(res.data);
+				}
+			});
+
+			std::shared_ptr<ArrayInstance> filtered = std::make_shared<ArrayInstance>((NativeArray*)arr->klass);
+			for (size_t i = 0; i < keep.size(); i++)
+			{
+				if (keep[i])
+					filtered->vec.push_back(arr->vec[i]);
+			}
+			return Value(std::shared_ptr<ToyInstance>(filtered));
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "filter";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodFilter>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	// reduce(fn, init) folds from init in order. reduce(fn, init, combine) may split large arrays: every
+	// chunk is folded from init and the chunk results are merged in order with combine(a, b), so
+	// init has to be neutral for combine and combine associative.
+	class MethodReduce : public ToyFunction
+	{
+	public:
+		MethodReduce()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			if (args.size() != 2 && args.size() != 3)
+				throw std::string("[ERROR] Array.reduce expects a function, an initial value and optionally a combine function.\n");
+			ArrayInstance* arr = (ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Callable* fn = callbackArg(args[0], 2, "Array.reduce");
+			Callable* combine = args.size() == 3 ? callbackArg(args[2], 2, "Array.reduce") : nullptr;
+			Value acc = args[1];
+			size_t chunks = combine ? parallelChunks(arr->vec.size()) : 1;
+			if (chunks == 1)
+			{
+				for (auto& val : arr->vec)
+					acc = fn->call(interpreter, { acc, val });
+				return acc;
+			}
+
+			std::vector<Value> partials(chunks);
+			std::vector<uint64_t> contexts = parallelRange(interpreter, arr->vec.size(), [&](Interpreter* context, size_t chunk, size_t begin, size_t end) {
+				Value part = acc;
+				for (size_t i = begin; i < end; i++)
+					part = fn->call(context, { part, arr->vec[i] });
+				partials[chunk] = part;
+			});
+			acc = partials[0];
+			interpreter->adopt(acc, contexts);
+			for (size_t c = 1; c < chunks; c++)
+			{
+				interpreter->adopt(partials[c], contexts);
+				acc = combine->call(interpreter, { acc, partials[c] });
+			}
+			return acc;
+		}
+
+		int arity() override
+		{
+			return -1;
+		}
+
+		std::string name() override
+		{
+			return "reduce";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodReduce>();
+			method->self = self;
+			return Value(method);
+		}
+	};
 public:
 	NativeArray()
 		: ToyClass("Array", {})
@@ -183,11 +682,79 @@ public:
 		this->methods["push"] = Value(std::make_shared<MethodPush>());
 		this->methods["pop"] = Value(std::make_shared<MethodPop>());
 		this->methods["size"] = Value(std::make_shared<MethodSize>());
+		this->methods["sort"] = Value(std::make_shared<MethodSort>());
+		this->methods["fill"] = Value(std::make_shared<MethodFill>());
+		this->methods["slice"] = Value(std::make_shared<MethodSlice>());
+		this->methods["reserve"] = Value(std::make_shared<MethodReserve>());
+		this->methods["indexOf"] = Value(std::make_shared<MethodIndexOf>());
+		this->methods["reverse"] = Value(std::make_shared<MethodReverse>());
+		this->methods["extend"] = Value(std::make_shared<MethodExtend>());
+		this->methods["join"] = Value(std::make_shared<MethodJoin>());
+		this->methods["map"] = Value(std::make_shared<MethodMap>());
+		this->methods["filter"] = Value(std::make_shared<MethodFilter>());
+		this->methods["reduce"] = Value(std::make_shared<MethodReduce>());
 	}
 
+	// Array() makes an empty array, Array(n, init) makes n copies of init.
 	Value call(Interpreter* interpreter, std::vector<Value> args) override
 	{
-		std::shared_ptr<ToyInstance> instance = std::make_shared<ArrayInstance>(this);
-		return Value(instance);
+		std::shared_ptr<ArrayInstance> instance = std::make_shared<ArrayInstance>(this);
+		if (args.size() == 2)
+		{
+			double size = wholeArg(args[0], "Array");
+			if (size < 0)
+				throw std::string("[ERROR] Array size can not be negative.\n");
+			if (size > MAX_WHOLE_ARG || size > instance->vec.max_size())
+				throw std::string("[ERROR] Array size is too large.\n");
+			instance->vec.assign((size_t)size, args[1]);
+		}
+		else if (args.size() != 0)
+		{
+			throw std::string("[ERROR] Array expects no arguments or a size and an initial value.\n");
+		}
+		return Value(std::shared_ptr<ToyInstance>(instance));
+	}
+
+	int arity() override
+	{
+		return -1;
+	}
+};
+
+// parallelFor(n, fn) calls fn(i) for every i in [0, n) across the pool, in no particular order, and
+// returns an Array of the results by index. Like a task, fn can not change objects it did not create.
+class NativeParallelFor : public Callable
+{
+public:
+	Value call(Interpreter* interpreter, std::vector<Value> args) override
+	{
+		double count = wholeArg(args[0], "parallelFor");
+		if (count > MAX_WHOLE_ARG)
+			throw std::string("[ERROR] Function 'parallelFor' count is too large.\n");
+		Callable* fn = callbackArg(args[1], 1, "parallelFor");
+		size_t n = count > 0 ? (size_t)count : 0;
+		std::vector<Value> results(n);
+		std::vector<uint64_t> contexts = parallelRange(interpreter, n, [&](Interpreter* context, size_t, size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				results[i] = fn->call(context, { Value((double)i) });
+		});
+
+		auto it = interpreter->owner->natives.find("Array");
+		NativeArray* arrayClass = (NativeArray*)std::get<std::shared_ptr<Callable>>(it->second.data).get();
+		std::shared_ptr<NativeArray::ArrayInstance> arr = std::make_shared<NativeArray::ArrayInstance>(arrayClass);
+		arr->vec = std::move(results);
+		for (auto& val : arr->vec)
+			interpreter->adopt(val, contexts);
+		return Value(std::shared_ptr<ToyInstance>(arr));
+	}
+
+	int arity() override
+	{
+		return 2;
+	}
+
+	std::string name() override
+	{
+		return "parallelFor";
 	}
 };
@@ -0,0 +1,467 @@
+#pragma once
+#include "Callable.hpp"
+#include "Output.h"
+
+#include <cstdio>
+#include <cstring>
+
+// File(path, mode) opens a file for reading ("r"), writing ("w") or appending ("a").
+// Reads go through a fixed size chunk buffer so lines are handed out without a call into the OS per line.
+class NativeFile : public ToyClass
+{
+public:
+	class FileInstance : public ToyInstance
+	{
+	public:
+		static constexpr size_t chunkSize = 1 << 20;
+
+		FILE* file;
+		bool writing;
+		std::unique_ptr<char[]> buffer;
+		size_t pos;
+		size_t end;
+		std::unique_ptr<Output> writer;
+
+		FileInstance(NativeFile* klass, FILE* file, bool writing)
+			: ToyInstance(klass), file(file), writing(writing), pos(0), end(0)
+		{
+			if (writing)
+				writer = std::make_unique<Output>(file);
+			else
+				buffer = std::make_unique<char[]>(chunkSize);
+		}
+
+		~FileInstance()
+		{
+			close();
+		}
+
+		void checkMode(bool write, const std::string& method)
+		{
+			if (!file)
+				throw "[ERROR] File." + method + " called on a closed file.\n";
+			if (write != writing)
+				throw "[ERROR] File." + method + " is not allowed in the mode the file was opened with.\n";
+		}
+
+		bool fill()
+		{
+			pos = 0;
+			end = fread(buffer.get(), 1, chunkSize, file);
+			return end > 0;
+		}
+
+		bool atEnd()
+		{
+			return pos == end && !fill();
+		}
+
+		// Reads up to the next newline, dropping it and a preceding '\r'. Returns false only when nothing is left.
+		bool readLine(std::string& line)
+		{
+			line.clear();
+			bool any = false;
+			while (pos < end || fill())
+			{
+				any = true;
+				char* start = buffer.get() + pos;
+				char* newline = (char*)memchr(start, '\n', end - pos);
+				if (newline)
+				{
+					line.append(start, newline);
+					pos += newline - start + 1;
+					break;
+				}
+				line.append(start, end - pos);
+				pos = end;
+			}
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			return any;
+		}
+
+		std::string readAll()
+		{
+			std::string all(buffer.get() + pos, end - pos);
+			pos = end;
+			while (fill())
+				all.append(buffer.get(), end);
+			pos = end;
+			return all;
+		}
+
+		void close()
+		{
+			if (!file)
+				return;
+			writer.reset();
+			fclose(file);
+			file = nullptr;
+		}
+	};
+
+	// Iterator returned by File.lines(), sharing the file's read buffer.
+	class LinesInstance : public ToyInstance
+	{
+	public:
+		std::shared_ptr<ToyInstance> file;
+		LinesInstance(ToyClass* klass)
+			: ToyInstance(klass) {}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			fn(Value(file));
+		}
+	};
+
+	class MethodReadLine : public ToyFunction
+	{
+	public:
+		MethodReadLine()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			FileInstance* file = writableSelf<FileInstance>(interpreter, self);
+			file->checkMode(false, "readLine");
+			std::string line;
+			if (!file->readLine(line))
+				throw std::string("[ERROR] File.readLine called at the end of the file.\n");
+			return Value(line);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "readLine";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodReadLine>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodReadAll : public ToyFunction
+	{
+	public:
+		MethodReadAll()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			FileInstance* file = writableSelf<FileInstance>(interpreter, self);
+			file->checkMode(false, "readAll");
+			return Value(file->readAll());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "readAll";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodReadAll>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodEof : public ToyFunction
+	{
+	public:
+		MethodEof()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			FileInstance* file = writableSelf<FileInstance>(interpreter, self);
+			file->checkMode(false, "eof");
+			return file->atEnd();
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "eof";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodEof>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodWrite : public ToyFunction
+	{
+	public:
+		MethodWrite()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			FileInstance* file = writableSelf<FileInstance>(interpreter, self);
+			file->checkMode(true, "write");
+			file->writer->write(args[0]);
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "write";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodWrite>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodFlush : public ToyFunction
+	{
+	public:
+		MethodFlush()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			FileInstance* file = writableSelf<FileInstance>(interpreter, self);
+			file->checkMode(true, "flush");
+			file->writer->flush();
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "flush";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodFlush>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodClose : public ToyFunction
+	{
+	public:
+		MethodClose()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			FileInstance* file = writableSelf<FileInstance>(interpreter, self);
+			file->close();
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "close";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodClose>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodLines : public ToyFunction
+	{
+	public:
+		MethodLines()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			FileInstance* file = (FileInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			file->checkMode(false, "lines");
+			NativeFile* klass = (NativeFile*)file->klass;
+			std::shared_ptr<LinesInstance> lines = std::make_shared<LinesInstance>(&klass->linesClass);
+			lines->file = std::get<std::shared_ptr<ToyInstance>>(self.data);
+			return Value(std::shared_ptr<ToyInstance>(lines));
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "lines";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodLines>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class NativeLines : public ToyClass
+	{
+	public:
+		class MethodHasNext : public ToyFunction
+		{
+		public:
+			MethodHasNext()
+				: ToyFunction(nullptr)
+			{}
+
+			Value call(Interpreter* interpreter, std::vector<Value>) override
+			{
+				LinesInstance* lines = (LinesInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+				FileInstance* file = (FileInstance*)lines->file.get();
+				interpreter->checkWrite(file);
+				file->checkMode(false, "lines");
+				return !file->atEnd();
+			}
+
+			int arity() override
+			{
+				return 0;
+			}
+
+			std::string name() override
+			{
+				return "hasNext";
+			}
+
+			Value bind(Value self) override
+			{
+				std::shared_ptr method = std::make_shared<MethodHasNext>();
+				method->self = self;
+				return Value(method);
+			}
+		};
+
+		class MethodNext : public ToyFunction
+		{
+		public:
+			MethodNext()
+				: ToyFunction(nullptr)
+			{}
+
+			Value call(Interpreter* interpreter, std::vector<Value>) override
+			{
+				LinesInstance* lines = (LinesInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+				FileInstance* file = (FileInstance*)lines->file.get();
+				interpreter->checkWrite(file);
+				file->checkMode(false, "lines");
+				std::string line;
+				if (!file->readLine(line))
+					throw std::string("[ERROR] Lines.next called at the end of the file.\n");
+				return Value(line);
+			}
+
+			int arity() override
+			{
+				return 0;
+			}
+
+			std::string name() override
+			{
+				return "next";
+			}
+
+			Value bind(Value self) override
+			{
+				std::shared_ptr method = std::make_shared<MethodNext>();
+				method->self = self;
+				return Value(method);
+			}
+		};
+
+	public:
+		NativeLines()
+			: ToyClass("Lines", {})
+		{
+			this->methods["hasNext"] = Value(std::make_shared<MethodHasNext>());
+			this->methods["next"] = Value(std::make_shared<MethodNext>());
+		}
+	};
+
+public:
+	NativeLines linesClass;
+
+	NativeFile()
+		: ToyClass("File", {})
+	{
+		this->methods["readLine"] = Value(std::make_shared<MethodReadLine>());
+		this->methods["readAll"] = Value(std::make_shared<MethodReadAll>());
+		this->methods["eof"] = Value(std::make_shared<MethodEof>());
+		this->methods["write"] = Value(std::make_shared<MethodWrite>());
+		this->methods["flush"] = Value(std::make_shared<MethodFlush>());
+		this->methods["close"] = Value(std::make_shared<MethodClose>());
+		this->methods["lines"] = Value(std::make_shared<MethodLines>());
+	}
+
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		if (args[0].tag != TypeTag::STRING || args[1].tag != TypeTag::STRING)
+			throw std::string("[ERROR] File expects a path and a mode string.\n");
+		const std::string& path = std::get<std::string>(args[0].data);
+		const std::string& mode = std::get<std::string>(args[1].data);
+		if (mode != "r" && mode != "w" && mode != "a")
+			throw "[ERROR] Invalid file mode '" + mode + "', expected \"r\", \"w\" or \"a\".\n";
+
+		FILE* file = fopen(path.c_str(), (mode + "b").c_str());
+		if (!file)
+			throw "[ERROR] Unable to open file with path: " + path + "\n";
+		std::shared_ptr<ToyInstance> instance = std::make_shared<FileInstance>(this, file, mode != "r");
+		return Value(instance);
+	}
+
+	int arity() override
+	{
+		return 2;
+	}
+};
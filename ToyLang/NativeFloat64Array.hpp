@@ -0,0 +1,403 @@
+#pragma once
+#include "Callable.hpp"
+#include "NativeFuncs.hpp"
+#include "Simd.hpp"
+
+// Array of numbers kept as contiguous doubles, bulk methods run natively over the whole buffer.
+class NativeFloat64Array : public ToyClass
+{
+public:
+	class Float64ArrayInstance : public ToyInstance
+	{
+	public:
+		std::vector<double> vec;
+		Float64ArrayInstance(NativeFloat64Array* klass)
+			: ToyInstance(klass) {}
+
+		size_t index(const Value& val)
+		{
+			double index = wholeArg(val, "Float64Array index");
+			if (index < 0 || index >= vec.size())
+				throw "[ERROR] Float64Array index " + val.toString() + " is out of range.\n";
+			return (size_t)index;
+		}
+
+		bool getIndex(const Value& index, Value& out) override
+		{
+			out = vec[this->index(index)];
+			return true;
+		}
+
+		bool setIndex(const Value& index, const Value& val) override
+		{
+			vec[this->index(index)] = numberArg(val, "Float64Array index set");
+			return true;
+		}
+
+		static Float64ArrayInstance* sameSize(Float64ArrayInstance* arr, const Value& val, const std::string& method)
+		{
+			Float64ArrayInstance* other = nullptr;
+			if (val.tag == TypeTag::INSTANCE)
+				other = dynamic_cast<Float64ArrayInstance*>(std::get<std::shared_ptr<ToyInstance>>(val.data).get());
+			if (!other)
+				throw "[ERROR] Float64Array." + method + " expects a Float64Array argument.\n";
+			if (other->vec.size() != arr->vec.size())
+				throw "[ERROR] Float64Array." + method + " expects arrays of the same size.\n";
+			return other;
+		}
+	};
+
+	class MethodGet : public ToyFunction
+	{
+	public:
+		MethodGet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			Float64ArrayInstance* arr = (Float64ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return arr->vec[arr->index(args[0])];
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "get";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodGet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSet : public ToyFunction
+	{
+	public:
+		MethodSet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			Float64ArrayInstance* arr = writableSelf<Float64ArrayInstance>(interpreter, self);
+			arr->vec[arr->index(args[0])] = numberArg(args[1], "Float64Array.set");
+			return args[1];
+		}
+
+		int arity() override
+		{
+			return 2;
+		}
+
+		std::string name() override
+		{
+			return "set";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPush : public ToyFunction
+	{
+	public:
+		MethodPush()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			writableSelf<Float64ArrayInstance>(interpreter, self)->vec.push_back(numberArg(args[0], "Float64Array.push"));
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "push";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPush>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSize : public ToyFunction
+	{
+	public:
+		MethodSize()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			Float64ArrayInstance* arr = (Float64ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return Value((double)arr->vec.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "size";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSize>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSum : public ToyFunction
+	{
+	public:
+		MethodSum()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			Float64ArrayInstance* arr = (Float64ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return simd::sum(arr->vec.data(), arr->vec.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "sum";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSum>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodDot : public ToyFunction
+	{
+	public:
+		MethodDot()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			Float64ArrayInstance* arr = (Float64ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Float64ArrayInstance* other = Float64ArrayInstance::sameSize(arr, args[0], "dot");
+			return simd::dot(arr->vec.data(), other->vec.data(), arr->vec.size());
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "dot";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodDot>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodScale : public ToyFunction
+	{
+	public:
+		MethodScale()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			Float64ArrayInstance* arr = writableSelf<Float64ArrayInstance>(interpreter, self);
+			simd::scale(arr->vec.data(), numberArg(args[0], "Float64Array.scale"), arr->vec.size());
+			return self;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "scale";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodScale>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodAdd : public ToyFunction
+	{
+	public:
+		MethodAdd()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			Float64ArrayInstance* arr = writableSelf<Float64ArrayInstance>(interpreter, self);
+			Float64ArrayInstance* other = Float64ArrayInstance::sameSize(arr, args[0], "add");
+			simd::add(arr->vec.data(), other->vec.data(), arr->vec.size());
+			return self;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "add";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodAdd>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodMin : public ToyFunction
+	{
+	public:
+		MethodMin()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			Float64ArrayInstance* arr = (Float64ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			if (arr->vec.empty())
+				throw std::string("[ERROR] Float64Array.min called on an empty array.\n");
+			return simd::min(arr->vec.data(), arr->vec.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "min";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodMin>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodMax : public ToyFunction
+	{
+	public:
+		MethodMax()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			Float64ArrayInstance* arr = (Float64ArrayInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			if (arr->vec.empty())
+				throw std::string("[ERROR] Float64Array.max called on an empty array.\n");
+			return simd::max(arr->vec.data(), arr->vec.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "max";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodMax>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+public:
+	NativeFloat64Array()
+		: ToyClass("Float64Array", {})
+	{
+		this->methods["get"] = Value(std::make_shared<MethodGet>());
+		this->methods["set"] = Value(std::make_shared<MethodSet>());
+		this->methods["__iget__"] = Value(std::make_shared<MethodGet>());
+		this->methods["__iset__"] = Value(std::make_shared<MethodSet>());
+		this->methods["push"] = Value(std::make_shared<MethodPush>());
+		this->methods["size"] = Value(std::make_shared<MethodSize>());
+		this->methods["sum"] = Value(std::make_shared<MethodSum>());
+		this->methods["dot"] = Value(std::make_shared<MethodDot>());
+		this->methods["scale"] = Value(std::make_shared<MethodScale>());
+		this->methods["add"] = Value(std::make_shared<MethodAdd>());
+		this->methods["min"] = Value(std::make_shared<MethodMin>());
+		this->methods["max"] = Value(std::make_shared<MethodMax>());
+	}
+
+	// Float64Array(n) makes an array of n zeros.
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		double size = wholeArg(args[0], "Float64Array");
+		if (size < 0)
+			throw std::string("[ERROR] Float64Array size can not be negative.\n");
+		std::shared_ptr<Float64ArrayInstance> instance = std::make_shared<Float64ArrayInstance>(this);
+		if (size > MAX_WHOLE_ARG || size > instance->vec.max_size())
+			throw std::string("[ERROR] Float64Array size is too large.\n");
+		instance->vec.resize((size_t)size);
+		return Value(std::shared_ptr<ToyInstance>(instance));
+	}
+
+	int arity() override
+	{
+		return 1;
+	}
+};
@@ -1,12 +1,36 @@
 #pragma once
 #include "Callable.hpp"
+#include "Output.h"
+
+#include <chrono>
+#include <cmath>
+
+inline double numberArg(const Value& val, const std::string& func)
+{
+	if (val.tag != TypeTag::NUMBER)
+		throw "[ERROR] Function '" + func + "' expects a number argument.\n";
+	return std::get<double>(val.data);
+}
+
+// Largest count or size accepted from a script, beyond it doubles stop being exact integers.
+constexpr double MAX_WHOLE_ARG = 9007199254740992.0;
+
+// For numbers about to be cast to size_t, where NaN would be undefined and fractions silently truncated.
+// Callers still check the sign and upper bound.
+inline double wholeArg(const Value& val, const std::string& func)
+{
+	double num = numberArg(val, func);
+	if (std::isnan(num) || std::floor(num) != num)
+		throw "[ERROR] Function '" + func + "' expects a whole number argument.\n";
+	return num;
+}
 
 class NativePrint : public Callable
 {
 public:
 	Value call(Interpreter* interpreter, std::vector<Value> args) override
 	{
-		std::cout << args[0];
+		interpreter->output->write(args[0]);
 		return Value();
 	}
 
@@ -21,13 +45,55 @@ public:
 	}
 };
 
+class NativePrintln : public Callable
+{
+public:
+	Value call(Interpreter* interpreter, std::vector<Value> args) override
+	{
+		interpreter->output->write(args[0]);
+		interpreter->output->write('\n');
+		return Value();
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "println";
+	}
+};
+
+class NativeFlush : public Callable
+{
+public:
+	Value call(Interpreter* interpreter, std::vector<Value>) override
+	{
+		interpreter->output->flush();
+		return Value();
+	}
+
+	int arity()
+	{
+		return 0;
+	}
+
+	std::string name() override
+	{
+		return "flush";
+	}
+};
+
 class NativeInput : public Callable
 {
 public:
 	Value call(Interpreter* interpreter, std::vector<Value> args) override
 	{
+		interpreter->output->flush();
 		std::string line;
-		std::getline(std::cin, line);
+		std::getline(*interpreter->input, line);
 		return Value(line);
 	}
 
@@ -79,3 +145,213 @@ public:
 		return "str";
 	}
 };
+
+class NativeNum : public Callable
+{
+public:
+	static Value parse(const Value& val)
+	{
+		if (val.tag == TypeTag::NUMBER)
+			return val;
+		double num;
+		if (val.tag != TypeTag::STRING)
+			throw std::string("[ERROR] Function 'num' expects a string argument.\n");
+		const std::string& str = std::get<std::string>(val.data);
+		if (!parseNumber(str.data(), str.data() + str.size(), num))
+			throw "[ERROR] Function 'num' can not parse '" + str + "' as a number.\n";
+		return num;
+	}
+
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return parse(args[0]);
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "num";
+	}
+};
+
+// Monotonic high resolution timer in seconds, meant for benchmarking.
+class NativeNow : public Callable
+{
+public:
+	static double now()
+	{
+		using namespace std::chrono;
+		return duration<double>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	Value call(Interpreter*, std::vector<Value>) override
+	{
+		return now();
+	}
+
+	int arity()
+	{
+		return 0;
+	}
+
+	std::string name() override
+	{
+		return "now";
+	}
+};
+
+class NativeSqrt : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::sqrt(numberArg(args[0], name()));
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "sqrt";
+	}
+};
+
+class NativeFloor : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::floor(numberArg(args[0], name()));
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "floor";
+	}
+};
+
+class NativeAbs : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::fabs(numberArg(args[0], name()));
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "abs";
+	}
+};
+
+class NativeSin : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::sin(numberArg(args[0], name()));
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "sin";
+	}
+};
+
+class NativeCos : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::cos(numberArg(args[0], name()));
+	}
+
+	int arity()
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "cos";
+	}
+};
+
+class NativeMin : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::fmin(numberArg(args[0], name()), numberArg(args[1], name()));
+	}
+
+	int arity()
+	{
+		return 2;
+	}
+
+	std::string name() override
+	{
+		return "min";
+	}
+};
+
+class NativeMax : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::fmax(numberArg(args[0], name()), numberArg(args[1], name()));
+	}
+
+	int arity()
+	{
+		return 2;
+	}
+
+	std::string name() override
+	{
+		return "max";
+	}
+};
+
+class NativePow : public Callable
+{
+public:
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		return std::pow(numberArg(args[0], name()), numberArg(args[1], name()));
+	}
+
+	int arity()
+	{
+		return 2;
+	}
+
+	std::string name() override
+	{
+		return "pow";
+	}
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include "Callable.hpp"
+#include "Generator.h"
+
+// Returned by calls to functions that yield. next() runs the body up to its next yield, hasNext()
+// runs ahead to the next yield once and keeps the value for next().
+class NativeGenerator : public ToyClass
+{
+public:
+	class GeneratorInstance : public ToyInstance
+	{
+	public:
+		Generator generator;
+		Value buffered;
+		bool hasBuffered;
+
+		GeneratorInstance(NativeGenerator* klass, StmtFunction* func, Enviroment* locals)
+			: ToyInstance(klass), generator(func, locals), hasBuffered(false) {}
+
+		bool hasNext(Interpreter* interpreter)
+		{
+			if (!hasBuffered)
+				hasBuffered = generator.resume(interpreter, buffered);
+			return hasBuffered;
+		}
+
+		bool advance(Interpreter* interpreter, Value& out)
+		{
+			if (!hasNext(interpreter))
+				return false;
+			out = std::move(buffered);
+			buffered = Value();
+			hasBuffered = false;
+			return true;
+		}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			generator.forEachValue(fn);
+			fn(buffered);
+		}
+	};
+
+	class MethodHasNext : public ToyFunction
+	{
+	public:
+		MethodHasNext()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			GeneratorInstance* gen = writableSelf<GeneratorInstance>(interpreter, self);
+			return gen->hasNext(interpreter);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "hasNext";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodHasNext>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodNext : public ToyFunction
+	{
+	public:
+		MethodNext()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			GeneratorInstance* gen = writableSelf<GeneratorInstance>(interpreter, self);
+			Value out;
+			if (!gen->advance(interpreter, out))
+				throw std::string("[ERROR] Generator.next called on a finished generator.\n");
+			return out;
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "next";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodNext>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	NativeGenerator()
+		: ToyClass("Generator", {})
+	{
+		this->methods["hasNext"] = Value(std::make_shared<MethodHasNext>());
+		this->methods["next"] = Value(std::make_shared<MethodNext>());
+	}
+
+	Value call(Interpreter*, std::vector<Value>) override
+	{
+		throw std::string("[ERROR] Generators are made by calling a function that yields.\n");
+	}
+
+	int arity() override
+	{
+		return 0;
+	}
+
+	Value start(StmtFunction* func, Enviroment* locals)
+	{
+		return Value(std::shared_ptr<ToyInstance>(std::make_shared<GeneratorInstance>(this, func, locals)));
+	}
+};
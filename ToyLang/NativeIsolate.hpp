@@ -0,0 +1,322 @@
+#pragma once
+#include "BoundedQueue.hpp"
+#include "Callable.hpp"
+#include "NativeArray.hpp"
+#include "NativeFloat64Array.hpp"
+#include "NativeTask.hpp"
+
+#include <thread>
+
+// A value detached from the heap of one isolate on its way to another. Arrays and Float64Arrays
+// travel as their storage, which is moved out of the sender, strings are moved along with it.
+struct Message
+{
+	enum class Kind
+	{
+		SCALAR, ARRAY, FLOAT64_ARRAY, CHANNEL
+	};
+
+	Kind kind = Kind::SCALAR;
+	Value scalar;
+	std::vector<Message> elements;
+	std::vector<double> numbers;
+	std::shared_ptr<BoundedQueue<Message>> channel;
+};
+
+typedef BoundedQueue<Message> ChannelQueue;
+
+class NativeChannel : public ToyClass
+{
+public:
+	// Handle in one heap, every isolate the channel was sent to has its own over the same queue.
+	class ChannelInstance : public ToyInstance
+	{
+	public:
+		std::shared_ptr<ChannelQueue> queue;
+
+		ChannelInstance(NativeChannel* klass, std::shared_ptr<ChannelQueue> queue)
+			: ToyInstance(klass), queue(queue) {}
+	};
+
+	// The native class of this name in the heap interpreter belongs to.
+	template<typename T>
+	static T* heapClass(Interpreter* interpreter, const std::string& name)
+	{
+		auto it = interpreter->owner->natives.find(name);
+		return (T*)std::get<std::shared_ptr<Callable>>(it->second.data).get();
+	}
+
+	// Arrays are emptied by sending them, so interpreter has to be allowed to change them.
+	static void checkSendable(Interpreter* interpreter, const Value& val, int depth)
+	{
+		if (depth > 64)
+			throw std::string("[ERROR] Value is nested too deeply to send.\n");
+		if (val.tag != TypeTag::CALLABLE && val.tag != TypeTag::INSTANCE)
+			return;
+		if (val.tag == TypeTag::INSTANCE)
+		{
+			ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(val.data).get();
+			if (auto arr = dynamic_cast<NativeArray::ArrayInstance*>(instance))
+			{
+				interpreter->checkWrite(arr);
+				for (auto& element : arr->vec)
+					checkSendable(interpreter, element, depth + 1);
+				return;
+			}
+			if (dynamic_cast<NativeFloat64Array::Float64ArrayInstance*>(instance))
+			{
+				interpreter->checkWrite(instance);
+				return;
+			}
+			if (dynamic_cast<ChannelInstance*>(instance))
+				return;
+		}
+		throw std::string("[ERROR] Only nil, bools, numbers, strings, Arrays, Float64Arrays and Channels can be sent to another isolate.\n");
+	}
+
+	// Detaches val from the sender's heap, arrays are left empty. Throws before touching anything if
+	// part of val can not be sent.
+	static Message pack(Interpreter* interpreter, Value val)
+	{
+		checkSendable(interpreter, val, 0);
+		return detach(val);
+	}
+
+	static Message detach(Value& val)
+	{
+		Message msg;
+		if (val.tag != TypeTag::INSTANCE)
+		{
+			msg.scalar = std::move(val);
+			return msg;
+		}
+
+		ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(val.data).get();
+		if (auto arr = dynamic_cast<NativeArray::ArrayInstance*>(instance))
+		{
+			msg.kind = Message::Kind::ARRAY;
+			msg.elements.reserve(arr->vec.size());
+			for (auto& element : arr->vec)
+				msg.elements.push_back(detach(element));
+			arr->vec.clear();
+		}
+		else if (auto arr = dynamic_cast<NativeFloat64Array::Float64ArrayInstance*>(instance))
+		{
+			msg.kind = Message::Kind::FLOAT64_ARRAY;
+			msg.numbers = std::move(arr->vec);
+			arr->vec.clear();
+		}
+		else
+		{
+			msg.kind = Message::Kind::CHANNEL;
+			msg.channel = ((ChannelInstance*)instance)->queue;
+		}
+		return msg;
+	}
+
+	// Rebuilds msg as objects of the heap interpreter belongs to.
+	static Value unpack(Interpreter* interpreter, Message& msg)
+	{
+		switch (msg.kind)
+		{
+		case Message::Kind::ARRAY:
+		{
+			std::shared_ptr<NativeArray::ArrayInstance> arr = std::make_shared<NativeArray::ArrayInstance>(heapClass<NativeArray>(interpreter, "Array"));
+			arr->vec.reserve(msg.elements.size());
+			for (auto& element : msg.elements)
+				arr->vec.push_back(unpack(interpreter, element));
+			return Value(std::shared_ptr<ToyInstance>(arr));
+		}
+		case Message::Kind::FLOAT64_ARRAY:
+		{
+			std::shared_ptr<NativeFloat64Array::Float64ArrayInstance> arr =
+				std::make_shared<NativeFloat64Array::Float64ArrayInstance>(heapClass<NativeFloat64Array>(interpreter, "Float64Array"));
+			arr->vec = std::move(msg.numbers);
+			return Value(std::shared_ptr<ToyInstance>(arr));
+		}
+		case Message::Kind::CHANNEL:
+			return Value(std::shared_ptr<ToyInstance>(std::make_shared<ChannelInstance>(heapClass<NativeChannel>(interpreter, "Channel"), msg.channel)));
+		default:
+			return std::move(msg.scalar);
+		}
+	}
+
+	class MethodSend : public ToyFunction
+	{
+	public:
+		MethodSend()
+			: ToyFunction(nullptr)
+		{}
+
+		// Waits while the channel is full.
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			ChannelInstance* channel = (ChannelInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			channel->queue->push(pack(interpreter, std::move(args[0])));
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "send";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSend>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodReceive : public ToyFunction
+	{
+	public:
+		MethodReceive()
+			: ToyFunction(nullptr)
+		{}
+
+		// Waits while the channel is empty.
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			ChannelInstance* channel = (ChannelInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Message msg = channel->queue->pop();
+			return unpack(interpreter, msg);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "receive";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodReceive>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	NativeChannel()
+		: ToyClass("Channel", {})
+	{
+		this->methods["send"] = Value(std::make_shared<MethodSend>());
+		this->methods["receive"] = Value(std::make_shared<MethodReceive>());
+	}
+
+	// Channel() holds up to 64 messages, Channel(n) up to n rounded up to a power of two.
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		size_t capacity = 64;
+		if (args.size() == 1)
+		{
+			double size = wholeArg(args[0], "Channel");
+			if (size < 1 || size > (1 << 24))
+				throw std::string("[ERROR] Channel capacity must be between 1 and 16777216.\n");
+			capacity = (size_t)size;
+		}
+		else if (args.size() != 0)
+		{
+			throw std::string("[ERROR] Channel expects no arguments or a capacity.\n");
+		}
+		return Value(std::shared_ptr<ToyInstance>(std::make_shared<ChannelInstance>(this, std::make_shared<ChannelQueue>(capacity))));
+	}
+
+	int arity() override
+	{
+		return -1;
+	}
+};
+
+// isolate(fn, args...) runs fn on a thread of its own in a fresh heap: the script's top level is run
+// again for its globals, init() is not. Arguments and the result are sent like channel messages and
+// the handle is joined like a task.
+class NativeIsolate : public Callable
+{
+public:
+	class IsolateInstance : public NativeTask::TaskInstance
+	{
+	public:
+		Message message;
+
+		IsolateInstance(NativeTask* klass)
+			: TaskInstance(klass) {}
+
+		Value resultFor(Interpreter* interpreter) override
+		{
+			return NativeChannel::unpack(interpreter, message);
+		}
+	};
+
+	Value call(Interpreter* interpreter, std::vector<Value> args) override
+	{
+		ToyFunction* entry = nullptr;
+		if (args.size() > 0 && args[0].tag == TypeTag::CALLABLE)
+			entry = dynamic_cast<ToyFunction*>(std::get<std::shared_ptr<Callable>>(args[0].data).get());
+		// Natives and bound methods belong to the sender's heap, only plain functions can start an isolate.
+		if (!entry || !entry->func || entry->self.tag != TypeTag::ERR)
+			throw std::string("[ERROR] Function 'isolate' expects a function declared with func.\n");
+		if (entry->arity() != (int)args.size() - 1)
+			throw std::string("[ERROR] Invalid function call with invalid argument count\n");
+
+		for (size_t i = 1; i < args.size(); i++)
+			NativeChannel::checkSendable(interpreter, args[i], 0);
+		std::vector<Message> messages;
+		for (size_t i = 1; i < args.size(); i++)
+			messages.push_back(NativeChannel::detach(args[i]));
+
+		std::shared_ptr<IsolateInstance> handle = std::make_shared<IsolateInstance>(interpreter->taskClass);
+		StmtFunction* func = entry->func;
+		Interpreter* owner = interpreter->owner;
+		interpreter->pendingIsolates++;
+		std::thread([handle, func, messages, owner, interpreter]() mutable {
+			{
+				Output output([&handle](const char* data, size_t size) { handle->output.append(data, size); });
+				std::unique_ptr<Interpreter> heap = owner->isolate(&output);
+				if (heap->prepare())
+				{
+					try
+					{
+						Interpreter::Running running(heap.get());
+						std::vector<Value> params;
+						for (auto& msg : messages)
+							params.push_back(NativeChannel::unpack(heap.get(), msg));
+						ToyFunction start(func);
+						handle->message = NativeChannel::pack(heap.get(), start.call(heap.get(), params));
+					}
+					catch (...)
+					{
+						handle->error = Interpreter::currentError();
+					}
+				}
+				else
+				{
+					handle->error = "[ERROR] Isolate stopped before '" + func->name.getLexeme() + "' could start.\n";
+				}
+			}
+			handle->complete();
+			interpreter->pendingIsolates--;
+		}).detach();
+		return Value(std::shared_ptr<ToyInstance>(handle));
+	}
+
+	int arity() override
+	{
+		return -1;
+	}
+
+	std::string name() override
+	{
+		return "isolate";
+	}
+};
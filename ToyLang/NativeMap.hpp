@@ -0,0 +1,554 @@
+#pragma once
+#include "Callable.hpp"
+#include "HashTable.hpp"
+#include "NativeArray.hpp"
+
+#include <cmath>
+
+inline void checkKey(const Value& key)
+{
+	if (key.tag == TypeTag::NUMBER && std::isnan(std::get<double>(key.data)))
+		throw std::string("[ERROR] NaN can not be used as a key.\n");
+}
+
+class NativeMap : public ToyClass
+{
+public:
+	class MapInstance : public ToyInstance
+	{
+	public:
+		HashTable<Value> table;
+		MapInstance(NativeMap* klass)
+			: ToyInstance(klass) {}
+
+		bool getIndex(const Value& index, Value& out) override
+		{
+			Value* val = table.find(index);
+			if (!val)
+				throw "[ERROR] Map does not contain the key " + index.toString() + ".\n";
+			out = *val;
+			return true;
+		}
+
+		bool setIndex(const Value& index, const Value& val) override
+		{
+			checkKey(index);
+			table.insert(index) = val;
+			return true;
+		}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			table.forEach([&fn](const Value& key, const Value& val) {
+				fn(key);
+				fn(val);
+			});
+		}
+	};
+
+	class MethodGet : public ToyFunction
+	{
+	public:
+		MethodGet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			MapInstance* map = (MapInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Value out;
+			map->getIndex(args[0], out);
+			return out;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "get";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodGet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSet : public ToyFunction
+	{
+	public:
+		MethodSet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			MapInstance* map = writableSelf<MapInstance>(interpreter, self);
+			map->setIndex(args[0], args[1]);
+			return args[1];
+		}
+
+		int arity() override
+		{
+			return 2;
+		}
+
+		std::string name() override
+		{
+			return "set";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodHas : public ToyFunction
+	{
+	public:
+		MethodHas()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			MapInstance* map = (MapInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return map->table.find(args[0]) != nullptr;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "has";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodHas>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodRemove : public ToyFunction
+	{
+	public:
+		MethodRemove()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			MapInstance* map = writableSelf<MapInstance>(interpreter, self);
+			return map->table.remove(args[0]);
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "remove";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodRemove>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSize : public ToyFunction
+	{
+	public:
+		MethodSize()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			MapInstance* map = (MapInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return Value((double)map->table.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "size";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSize>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodKeys : public ToyFunction
+	{
+	public:
+		MethodKeys()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			MapInstance* map = (MapInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			NativeArray* arrayClass = ((NativeMap*)map->klass)->arrayClass;
+			std::shared_ptr<NativeArray::ArrayInstance> keys = std::make_shared<NativeArray::ArrayInstance>(arrayClass);
+			keys->vec.reserve(map->table.size());
+			map->table.forEach([&keys](const Value& key, Value&) { keys->vec.push_back(key); });
+			return Value(std::shared_ptr<ToyInstance>(keys));
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "keys";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodKeys>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodValues : public ToyFunction
+	{
+	public:
+		MethodValues()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			MapInstance* map = (MapInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			NativeArray* arrayClass = ((NativeMap*)map->klass)->arrayClass;
+			std::shared_ptr<NativeArray::ArrayInstance> values = std::make_shared<NativeArray::ArrayInstance>(arrayClass);
+			values->vec.reserve(map->table.size());
+			map->table.forEach([&values](const Value&, Value& val) { values->vec.push_back(val); });
+			return Value(std::shared_ptr<ToyInstance>(values));
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "values";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodValues>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+public:
+	NativeArray* arrayClass;
+
+	NativeMap(NativeArray* arrayClass)
+		: ToyClass("Map", {}), arrayClass(arrayClass)
+	{
+		this->methods["get"] = Value(std::make_shared<MethodGet>());
+		this->methods["set"] = Value(std::make_shared<MethodSet>());
+		this->methods["__iget__"] = Value(std::make_shared<MethodGet>());
+		this->methods["__iset__"] = Value(std::make_shared<MethodSet>());
+		this->methods["has"] = Value(std::make_shared<MethodHas>());
+		this->methods["remove"] = Value(std::make_shared<MethodRemove>());
+		this->methods["size"] = Value(std::make_shared<MethodSize>());
+		this->methods["keys"] = Value(std::make_shared<MethodKeys>());
+		this->methods["values"] = Value(std::make_shared<MethodValues>());
+	}
+
+	Value call(Interpreter*, std::vector<Value>) override
+	{
+		std::shared_ptr<ToyInstance> instance = std::make_shared<MapInstance>(this);
+		return Value(instance);
+	}
+};
+
+class NativeSet : public ToyClass
+{
+public:
+	class SetInstance : public ToyInstance
+	{
+	public:
+		HashTable<bool> table;
+		SetInstance(NativeSet* klass)
+			: ToyInstance(klass) {}
+
+		// set[key] tells whether key is in the set
+		bool getIndex(const Value& index, Value& out) override
+		{
+			out = Value(table.find(index) != nullptr);
+			return true;
+		}
+
+		// set[key] = true adds key, set[key] = false removes it
+		bool setIndex(const Value& index, const Value& val) override
+		{
+			if (val.tag != TypeTag::BOOL)
+				throw std::string("[ERROR] Set elements can only be assigned a bool.\n");
+			if (std::get<bool>(val.data))
+			{
+				checkKey(index);
+				table.insert(index) = true;
+			}
+			else
+				table.remove(index);
+			return true;
+		}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			table.forEach([&fn](const Value& key, bool) { fn(key); });
+		}
+	};
+
+	class MethodGet : public ToyFunction
+	{
+	public:
+		MethodGet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			SetInstance* set = (SetInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			Value out;
+			set->getIndex(args[0], out);
+			return out;
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "has";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodGet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSet : public ToyFunction
+	{
+	public:
+		MethodSet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			SetInstance* set = writableSelf<SetInstance>(interpreter, self);
+			set->setIndex(args[0], args[1]);
+			return args[1];
+		}
+
+		int arity() override
+		{
+			return 2;
+		}
+
+		std::string name() override
+		{
+			return "__iset__";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodAdd : public ToyFunction
+	{
+	public:
+		MethodAdd()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			SetInstance* set = writableSelf<SetInstance>(interpreter, self);
+			checkKey(args[0]);
+			set->table.insert(args[0]) = true;
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "add";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodAdd>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodRemove : public ToyFunction
+	{
+	public:
+		MethodRemove()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			SetInstance* set = writableSelf<SetInstance>(interpreter, self);
+			return set->table.remove(args[0]);
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "remove";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodRemove>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSize : public ToyFunction
+	{
+	public:
+		MethodSize()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			SetInstance* set = (SetInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return Value((double)set->table.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "size";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSize>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodValues : public ToyFunction
+	{
+	public:
+		MethodValues()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			SetInstance* set = (SetInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			NativeArray* arrayClass = ((NativeSet*)set->klass)->arrayClass;
+			std::shared_ptr<NativeArray::ArrayInstance> values = std::make_shared<NativeArray::ArrayInstance>(arrayClass);
+			values->vec.reserve(set->table.size());
+			set->table.forEach([&values](const Value& key, bool&) { values->vec.push_back(key); });
+			return Value(std::shared_ptr<ToyInstance>(values));
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "values";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodValues>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+public:
+	NativeArray* arrayClass;
+
+	NativeSet(NativeArray* arrayClass)
+		: ToyClass("Set", {}), arrayClass(arrayClass)
+	{
+		this->methods["has"] = Value(std::make_shared<MethodGet>());
+		this->methods["__iget__"] = Value(std::make_shared<MethodGet>());
+		this->methods["__iset__"] = Value(std::make_shared<MethodSet>());
+		this->methods["add"] = Value(std::make_shared<MethodAdd>());
+		this->methods["remove"] = Value(std::make_shared<MethodRemove>());
+		this->methods["size"] = Value(std::make_shared<MethodSize>());
+		this->methods["values"] = Value(std::make_shared<MethodValues>());
+		// Same array as values(), so code written against Map reads the members of a Set too.
+		this->methods["keys"] = Value(std::make_shared<MethodValues>());
+	}
+
+	Value call(Interpreter*, std::vector<Value>) override
+	{
+		std::shared_ptr<ToyInstance> instance = std::make_shared<SetInstance>(this);
+		return Value(instance);
+	}
+};
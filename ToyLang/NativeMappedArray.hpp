@@ -0,0 +1,255 @@
+#pragma once
+#include "Callable.hpp"
+#include "MappedFile.h"
+#include "NativeFuncs.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// MappedArray(path, type) maps a binary file of fixed width records read only,
+// MappedArray(path, type, true) maps it read write. Types are f64, f32, i64, i32, i16, i8, u32, u16 and u8.
+class NativeMappedArray : public ToyClass
+{
+public:
+	enum class RecordType
+	{
+		F64, F32, I64, I32, I16, I8, U32, U16, U8
+	};
+
+	class MappedInstance : public ToyInstance
+	{
+	public:
+		MappedFile file;
+		RecordType type;
+		size_t width;
+		size_t count;
+		bool writable;
+
+		MappedInstance(NativeMappedArray* klass, RecordType type, size_t width, bool writable)
+			: ToyInstance(klass), type(type), width(width), count(0), writable(writable) {}
+
+		template<typename T>
+		double loadAs(const char* ptr)
+		{
+			T val;
+			memcpy(&val, ptr, sizeof(T));
+			return (double)val;
+		}
+
+		// Casting NaN, a fraction or a number out of range to an integer type is undefined, those are rejected.
+		template<typename T>
+		void storeAs(char* ptr, double num)
+		{
+			if constexpr (std::is_integral<T>::value)
+			{
+				double limit = std::ldexp(1.0, std::numeric_limits<T>::digits);
+				double lowest = std::is_signed<T>::value ? -limit : 0.0;
+				if (!(num >= lowest && num < limit) || std::floor(num) != num)
+					throw "[ERROR] MappedArray can not store " + Value(num).toString() + " in a record of this type.\n";
+			}
+			T val = (T)num;
+			memcpy(ptr, &val, sizeof(T));
+		}
+
+		double load(size_t i)
+		{
+			const char* ptr = file.data() + i * width;
+			switch (type)
+			{
+			case RecordType::F64: return loadAs<double>(ptr);
+			case RecordType::F32: return loadAs<float>(ptr);
+			case RecordType::I64: return loadAs<int64_t>(ptr);
+			case RecordType::I32: return loadAs<int32_t>(ptr);
+			case RecordType::I16: return loadAs<int16_t>(ptr);
+			case RecordType::I8: return loadAs<int8_t>(ptr);
+			case RecordType::U32: return loadAs<uint32_t>(ptr);
+			case RecordType::U16: return loadAs<uint16_t>(ptr);
+			case RecordType::U8: return loadAs<uint8_t>(ptr);
+			default: return 0;
+			}
+		}
+
+		void store(size_t i, const Value& val)
+		{
+			if (!writable)
+				throw std::string("[ERROR] MappedArray was opened read only.\n");
+			double num = numberArg(val, "MappedArray index set");
+			char* ptr = file.data() + i * width;
+			switch (type)
+			{
+			case RecordType::F64: storeAs<double>(ptr, num); break;
+			case RecordType::F32: storeAs<float>(ptr, num); break;
+			case RecordType::I64: storeAs<int64_t>(ptr, num); break;
+			case RecordType::I32: storeAs<int32_t>(ptr, num); break;
+			case RecordType::I16: storeAs<int16_t>(ptr, num); break;
+			case RecordType::I8: storeAs<int8_t>(ptr, num); break;
+			case RecordType::U32: storeAs<uint32_t>(ptr, num); break;
+			case RecordType::U16: storeAs<uint16_t>(ptr, num); break;
+			case RecordType::U8: storeAs<uint8_t>(ptr, num); break;
+			}
+		}
+
+		size_t index(const Value& val)
+		{
+			double index = wholeArg(val, "MappedArray index");
+			if (index < 0 || index >= count)
+				throw "[ERROR] MappedArray index " + val.toString() + " is out of range.\n";
+			return (size_t)index;
+		}
+
+		bool getIndex(const Value& index, Value& out) override
+		{
+			out = load(this->index(index));
+			return true;
+		}
+
+		bool setIndex(const Value& index, const Value& val) override
+		{
+			store(this->index(index), val);
+			return true;
+		}
+	};
+
+	class MethodGet : public ToyFunction
+	{
+	public:
+		MethodGet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			MappedInstance* arr = (MappedInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return arr->load(arr->index(args[0]));
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "get";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodGet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSet : public ToyFunction
+	{
+	public:
+		MethodSet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			MappedInstance* arr = writableSelf<MappedInstance>(interpreter, self);
+			arr->store(arr->index(args[0]), args[1]);
+			return args[1];
+		}
+
+		int arity() override
+		{
+			return 2;
+		}
+
+		std::string name() override
+		{
+			return "set";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSize : public ToyFunction
+	{
+	public:
+		MethodSize()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			MappedInstance* arr = (MappedInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return Value((double)arr->count);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "size";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSize>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+public:
+	NativeMappedArray()
+		: ToyClass("MappedArray", {})
+	{
+		this->methods["get"] = Value(std::make_shared<MethodGet>());
+		this->methods["set"] = Value(std::make_shared<MethodSet>());
+		this->methods["__iget__"] = Value(std::make_shared<MethodGet>());
+		this->methods["__iset__"] = Value(std::make_shared<MethodSet>());
+		this->methods["size"] = Value(std::make_shared<MethodSize>());
+	}
+
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		static const std::unordered_map<std::string, std::pair<RecordType, size_t>> types = {
+			{ "f64", { RecordType::F64, 8 } },
+			{ "f32", { RecordType::F32, 4 } },
+			{ "i64", { RecordType::I64, 8 } },
+			{ "i32", { RecordType::I32, 4 } },
+			{ "i16", { RecordType::I16, 2 } },
+			{ "i8", { RecordType::I8, 1 } },
+			{ "u32", { RecordType::U32, 4 } },
+			{ "u16", { RecordType::U16, 2 } },
+			{ "u8", { RecordType::U8, 1 } },
+		};
+
+		if ((args.size() != 2 && args.size() != 3) || args[0].tag != TypeTag::STRING || args[1].tag != TypeTag::STRING
+			|| (args.size() == 3 && args[2].tag != TypeTag::BOOL))
+			throw std::string("[ERROR] MappedArray expects a path, a record type and optionally whether it is writable.\n");
+
+		const std::string& path = std::get<std::string>(args[0].data);
+		auto type = types.find(std::get<std::string>(args[1].data));
+		if (type == types.end())
+			throw "[ERROR] Unknown MappedArray record type '" + std::get<std::string>(args[1].data) + "'.\n";
+		bool writable = args.size() == 3 && std::get<bool>(args[2].data);
+
+		std::shared_ptr<MappedInstance> instance = std::make_shared<MappedInstance>(this, type->second.first, type->second.second, writable);
+		if (!instance->file.open(path, writable))
+			throw "[ERROR] Unable to map file with path: " + path + "\n";
+		instance->count = instance->file.size() / instance->width;
+		return Value(std::shared_ptr<ToyInstance>(instance));
+	}
+
+	int arity() override
+	{
+		return -1;
+	}
+};
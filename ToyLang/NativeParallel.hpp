@@ -0,0 +1,101 @@
+#pragma once
+#include "Callable.hpp"
+#include "NativeFuncs.hpp"
+#include "Output.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Ranges shorter than this run on the calling interpreter, a few hundred calls cost less than handing them out.
+constexpr size_t PARALLEL_MIN_SIZE = 1024;
+
+// Number of chunks parallelRange() splits n indices into, 1 when the range runs inline.
+inline size_t parallelChunks(size_t n)
+{
+	size_t workers = ThreadPool::shared().size();
+	if (n < PARALLEL_MIN_SIZE || workers < 2)
+		return 1;
+	// A few chunks per worker so an uneven chunk does not leave the others idle.
+	return std::min(workers * 4, n / (PARALLEL_MIN_SIZE / 4));
+}
+
+// Calls body(context, chunk, begin, end) for every chunk of [0, n) on the shared pool, each chunk in an
+// interpreter of its own over the globals of interpreter like a spawned task. What the chunks print is
+// written in index order and the first error is rethrown once every chunk is done. Short ranges run
+// inline in a single context. Returns the context ids of the chunks, whose objects the caller adopts
+// from what it keeps of their results.
+inline std::vector<uint64_t> parallelRange(Interpreter* interpreter, size_t n, const std::function<void(Interpreter*, size_t, size_t, size_t)>& body)
+{
+	size_t chunks = parallelChunks(n);
+	Interpreter* owner = interpreter->owner;
+	if (chunks == 1)
+	{
+		// Still in a context of its own, so what body may change does not depend on the number of cores.
+		Interpreter context(owner, interpreter->output);
+		Interpreter::Running running(&context);
+		body(&context, 0, 0, n);
+		return { context.contextId };
+	}
+
+	struct Chunk
+	{
+		std::string output;
+		std::string error;
+		uint64_t context = 0;
+	};
+	std::vector<Chunk> results(chunks);
+	std::atomic<size_t> remaining(chunks);
+	ThreadPool& pool = ThreadPool::shared();
+	for (size_t c = 0; c < chunks; c++)
+	{
+		pool.submit([&, c]() {
+			{
+				Output output([&results, c](const char* data, size_t size) { results[c].output.append(data, size); });
+				Interpreter context(owner, &output);
+				Interpreter::Running running(&context);
+				results[c].context = context.contextId;
+				try
+				{
+					body(&context, c, c * n / chunks, (c + 1) * n / chunks);
+				}
+				catch (...)
+				{
+					// Like a task, anything escaping a pool thread would end the process.
+					results[c].error = Interpreter::currentError();
+				}
+			}
+			remaining--;
+		});
+	}
+
+	while (remaining > 0)
+	{
+		if (!pool.runPending())
+			std::this_thread::yield();
+	}
+
+	for (Chunk& chunk : results)
+		interpreter->output->write(chunk.output);
+	std::vector<uint64_t> contexts;
+	for (Chunk& chunk : results)
+	{
+		if (!chunk.error.empty())
+			throw chunk.error;
+		contexts.push_back(chunk.context);
+	}
+	return contexts;
+}
+
+inline Callable* callbackArg(const Value& val, int params, const std::string& func)
+{
+	if (val.tag == TypeTag::CALLABLE)
+	{
+		Callable* callable = std::get<std::shared_ptr<Callable>>(val.data).get();
+		if (callable->arity() == params || callable->arity() == -1)
+			return callable;
+	}
+	throw "[ERROR] Function '" + func + "' expects a function with " + std::to_string(params) + (params == 1 ? " parameter.\n" : " parameters.\n");
+}
@@ -0,0 +1,618 @@
+#pragma once
+#include "Callable.hpp"
+#include "NativeFuncs.hpp"
+
+// Double ended queue over a power of two ring buffer.
+class NativeDeque : public ToyClass
+{
+public:
+	class DequeInstance : public ToyInstance
+	{
+	public:
+		std::vector<Value> buffer;
+		size_t head;
+		size_t count;
+
+		DequeInstance(NativeDeque* klass)
+			: ToyInstance(klass), head(0), count(0) {}
+
+		Value& at(size_t i)
+		{
+			return buffer[(head + i) & (buffer.size() - 1)];
+		}
+
+		void reserve(size_t size)
+		{
+			if (size <= buffer.size())
+				return;
+			size_t capacity = buffer.empty() ? 8 : buffer.size() * 2;
+			std::vector<Value> grown(capacity);
+			for (size_t i = 0; i < count; i++)
+				grown[i] = std::move(at(i));
+			buffer = std::move(grown);
+			head = 0;
+		}
+
+		size_t index(const Value& val)
+		{
+			if (val.tag != TypeTag::NUMBER)
+				throw std::string("[ERROR] Deque index must be a number.\n");
+			double index = wholeArg(val, "Deque index");
+			if (index < 0 || index >= count)
+				throw "[ERROR] Deque index " + val.toString() + " is out of range.\n";
+			return (size_t)index;
+		}
+
+		void checkEmpty(const std::string& method)
+		{
+			if (count == 0)
+				throw "[ERROR] Deque." + method + " called on an empty deque.\n";
+		}
+
+		bool getIndex(const Value& index, Value& out) override
+		{
+			out = at(this->index(index));
+			return true;
+		}
+
+		bool setIndex(const Value& index, const Value& val) override
+		{
+			at(this->index(index)) = val;
+			return true;
+		}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			for (size_t i = 0; i < count; i++)
+				fn(at(i));
+		}
+	};
+
+	class MethodGet : public ToyFunction
+	{
+	public:
+		MethodGet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value> args) override
+		{
+			DequeInstance* deque = (DequeInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return deque->at(deque->index(args[0]));
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "get";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodGet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSet : public ToyFunction
+	{
+	public:
+		MethodSet()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			DequeInstance* deque = writableSelf<DequeInstance>(interpreter, self);
+			deque->at(deque->index(args[0])) = args[1];
+			return args[1];
+		}
+
+		int arity() override
+		{
+			return 2;
+		}
+
+		std::string name() override
+		{
+			return "set";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSet>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPushBack : public ToyFunction
+	{
+	public:
+		MethodPushBack()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			DequeInstance* deque = writableSelf<DequeInstance>(interpreter, self);
+			deque->reserve(deque->count + 1);
+			deque->at(deque->count++) = args[0];
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "pushBack";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPushBack>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPushFront : public ToyFunction
+	{
+	public:
+		MethodPushFront()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			DequeInstance* deque = writableSelf<DequeInstance>(interpreter, self);
+			deque->reserve(deque->count + 1);
+			deque->head = (deque->head + deque->buffer.size() - 1) & (deque->buffer.size() - 1);
+			deque->count++;
+			deque->at(0) = args[0];
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "pushFront";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPushFront>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPopBack : public ToyFunction
+	{
+	public:
+		MethodPopBack()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			DequeInstance* deque = writableSelf<DequeInstance>(interpreter, self);
+			deque->checkEmpty("popBack");
+			Value back = std::move(deque->at(deque->count - 1));
+			deque->at(deque->count - 1) = Value();
+			deque->count--;
+			return back;
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "popBack";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPopBack>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPopFront : public ToyFunction
+	{
+	public:
+		MethodPopFront()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			DequeInstance* deque = writableSelf<DequeInstance>(interpreter, self);
+			deque->checkEmpty("popFront");
+			Value front = std::move(deque->at(0));
+			deque->at(0) = Value();
+			deque->head = (deque->head + 1) & (deque->buffer.size() - 1);
+			deque->count--;
+			return front;
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "popFront";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPopFront>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodFront : public ToyFunction
+	{
+	public:
+		MethodFront()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			DequeInstance* deque = (DequeInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			deque->checkEmpty("front");
+			return deque->at(0);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "front";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodFront>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodBack : public ToyFunction
+	{
+	public:
+		MethodBack()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			DequeInstance* deque = (DequeInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			deque->checkEmpty("back");
+			return deque->at(deque->count - 1);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "back";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodBack>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSize : public ToyFunction
+	{
+	public:
+		MethodSize()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			DequeInstance* deque = (DequeInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return Value((double)deque->count);
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "size";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSize>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+public:
+	NativeDeque()
+		: ToyClass("Deque", {})
+	{
+		this->methods["get"] = Value(std::make_shared<MethodGet>());
+		this->methods["set"] = Value(std::make_shared<MethodSet>());
+		this->methods["__iget__"] = Value(std::make_shared<MethodGet>());
+		this->methods["__iset__"] = Value(std::make_shared<MethodSet>());
+		this->methods["pushBack"] = Value(std::make_shared<MethodPushBack>());
+		this->methods["pushFront"] = Value(std::make_shared<MethodPushFront>());
+		this->methods["popBack"] = Value(std::make_shared<MethodPopBack>());
+		this->methods["popFront"] = Value(std::make_shared<MethodPopFront>());
+		this->methods["front"] = Value(std::make_shared<MethodFront>());
+		this->methods["back"] = Value(std::make_shared<MethodBack>());
+		this->methods["size"] = Value(std::make_shared<MethodSize>());
+	}
+
+	Value call(Interpreter*, std::vector<Value>) override
+	{
+		std::shared_ptr<ToyInstance> instance = std::make_shared<DequeInstance>(this);
+		return Value(instance);
+	}
+};
+
+// Binary heap, pops the smallest number or string first unless a comparator is given.
+// With PriorityQueue(cmp), cmp(a, b) returns true when a should be popped before b.
+class NativePriorityQueue : public ToyClass
+{
+public:
+	class QueueInstance : public ToyInstance
+	{
+	public:
+		std::vector<Value> heap;
+		Value comparator;
+
+		QueueInstance(NativePriorityQueue* klass)
+			: ToyInstance(klass) {}
+
+		void forEachValue(const std::function<void(const Value&)>& fn) override
+		{
+			for (auto& val : heap)
+				fn(val);
+			fn(comparator);
+		}
+
+		bool before(Interpreter* interpreter, const Value& a, const Value& b)
+		{
+			if (comparator.tag == TypeTag::CALLABLE)
+			{
+				Value res = std::get<std::shared_ptr<Callable>>(comparator.data)->call(interpreter, { a, b });
+				if (res.tag != TypeTag::BOOL)
+					throw std::string("[ERROR] PriorityQueue comparator must return a bool.\n");
+				return std::get<bool>(res.data);
+			}
+			if (a.tag == TypeTag::NUMBER && b.tag == TypeTag::NUMBER)
+				return std::get<double>(a.data) < std::get<double>(b.data);
+			if (a.tag == TypeTag::STRING && b.tag == TypeTag::STRING)
+				return std::get<std::string>(a.data) < std::get<std::string>(b.data);
+			throw std::string("[ERROR] PriorityQueue without a comparator needs all numbers or all strings.\n");
+		}
+
+		void siftUp(Interpreter* interpreter, size_t i)
+		{
+			while (i > 0)
+			{
+				size_t parent = (i - 1) / 2;
+				if (!before(interpreter, heap[i], heap[parent]))
+					break;
+				std::swap(heap[i], heap[parent]);
+				i = parent;
+			}
+		}
+
+		void siftDown(Interpreter* interpreter, size_t i)
+		{
+			size_t size = heap.size();
+			while (true)
+			{
+				size_t best = i;
+				size_t left = 2 * i + 1;
+				size_t right = left + 1;
+				if (left < size && before(interpreter, heap[left], heap[best]))
+					best = left;
+				if (right < size && before(interpreter, heap[right], heap[best]))
+					best = right;
+				if (best == i)
+					break;
+				std::swap(heap[i], heap[best]);
+				i = best;
+			}
+		}
+	};
+
+	class MethodPush : public ToyFunction
+	{
+	public:
+		MethodPush()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value> args) override
+		{
+			QueueInstance* queue = writableSelf<QueueInstance>(interpreter, self);
+			queue->heap.push_back(args[0]);
+			queue->siftUp(interpreter, queue->heap.size() - 1);
+			return Value();
+		}
+
+		int arity() override
+		{
+			return 1;
+		}
+
+		std::string name() override
+		{
+			return "push";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPush>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPop : public ToyFunction
+	{
+	public:
+		MethodPop()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter* interpreter, std::vector<Value>) override
+		{
+			QueueInstance* queue = writableSelf<QueueInstance>(interpreter, self);
+			if (queue->heap.empty())
+				throw std::string("[ERROR] PriorityQueue.pop called on an empty queue.\n");
+			Value top = std::move(queue->heap.front());
+			queue->heap.front() = std::move(queue->heap.back());
+			queue->heap.pop_back();
+			if (!queue->heap.empty())
+				queue->siftDown(interpreter, 0);
+			return top;
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "pop";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPop>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodPeek : public ToyFunction
+	{
+	public:
+		MethodPeek()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			QueueInstance* queue = (QueueInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			if (queue->heap.empty())
+				throw std::string("[ERROR] PriorityQueue.peek called on an empty queue.\n");
+			return queue->heap.front();
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "peek";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodPeek>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+
+	class MethodSize : public ToyFunction
+	{
+	public:
+		MethodSize()
+			: ToyFunction(nullptr)
+		{}
+
+		Value call(Interpreter*, std::vector<Value>) override
+		{
+			QueueInstance* queue = (QueueInstance*)std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+			return Value((double)queue->heap.size());
+		}
+
+		int arity() override
+		{
+			return 0;
+		}
+
+		std::string name() override
+		{
+			return "size";
+		}
+
+		Value bind(Value self) override
+		{
+			std::shared_ptr method = std::make_shared<MethodSize>();
+			method->self = self;
+			return Value(method);
+		}
+	};
+public:
+	NativePriorityQueue()
+		: ToyClass("PriorityQueue", {})
+	{
+		this->methods["push"] = Value(std::make_shared<MethodPush>());
+		this->methods["pop"] = Value(std::make_shared<MethodPop>());
+		this->methods["peek"] = Value(std::make_shared<MethodPeek>());
+		this->methods["size"] = Value(std::make_shared<MethodSize>());
+	}
+
+	Value call(Interpreter*, std::vector<Value> args) override
+	{
+		std::shared_ptr<QueueInstance> instance = std::make_shared<QueueInstance>(this);
+		if (args.size() == 1 && args[0].tag == TypeTag::CALLABLE && std::get<std::shared_ptr<Callable>>(args[0].data)->arity() == 2)
+			instance->comparator = args[0];
+		else if (args.size() != 0)
+			throw std::string("[ERROR] PriorityQueue expects no arguments or a comparator with 2 parameters.\n");
+		return Value(std::shared_ptr<ToyInstance>(instance));
+	}
+
+	int arity() override
+	{
+		return -1;
+	}
+};
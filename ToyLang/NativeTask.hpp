@@ -0,0 +1,144 @@
+#pragma once
+#include "Callable.hpp"
+#include "Output.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Handle returned by spawn. The call runs on the shared pool in an interpreter of its own over the
+// spawner's globals, what it prints is kept and written out by the thread that joins it. The first
+// context to join it takes over the objects the task created.
+class NativeTask : public ToyClass
+{
+public:
+	class TaskInstance : public ToyInstance
+	{
+	public:
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::atomic<bool> done;
+		Value result;
+		std::string output;
+		std::string error;
+		// Context id of the task's interpreter and of the one that joined it first, 0 until then.
+		uint64_t context;
+		uint64_t joinedBy;
+
+		TaskInstance(NativeTask* klass)
+			: ToyInstance(klass), done(false), context(0), joinedBy(0) {}
+
+		// The result as a value of the joining interpreter's heap.
+		virtual Value resultFor(Interpreter*)
+		{
+			return result;
+		}
+
+		void complete()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done = true;
+			}
+			finished.notify_all();
+		}
+	};
+
+	NativeTask()
+		: ToyClass("Task", {})
+	{}
+
+	Value call(Interpreter*, std::vector<Value>) override
+	{
+		throw std::string("[ERROR] Tasks are only created by spawn.\n");
+	}
+
+	int arity() override
+	{
+		return 0;
+	}
+
+	Value spawn(Interpreter* interpreter, std::shared_ptr<Callable> callable, std::vector<Value> args)
+	{
+		std::shared_ptr<TaskInstance> task = std::make_shared<TaskInstance>(this);
+		Interpreter* owner = interpreter->owner;
+		interpreter->beginTask(args);
+		interpreter->freeze(Value(callable));
+		ThreadPool::shared().submit([task, callable, args, owner, interpreter]() {
+			{
+				Output output([&task](const char* data, size_t size) { task->output.append(data, size); });
+				Interpreter context(owner, &output);
+				Interpreter::Running running(&context);
+				task->context = context.contextId;
+				try
+				{
+					task->result = callable->call(&context, args);
+				}
+				catch (...)
+				{
+					// Anything escaping here would end the process and leave the joiner waiting.
+					task->error = Interpreter::currentError();
+				}
+			}
+			task->complete();
+			interpreter->pendingTasks--;
+		});
+		return Value(std::shared_ptr<ToyInstance>(task));
+	}
+
+	// Runs other tasks while the awaited one is not done, so joining from inside a task never idles a worker.
+	static void await(TaskInstance* task)
+	{
+		while (!task->done)
+		{
+			if (ThreadPool::shared().runPending())
+				continue;
+			std::unique_lock<std::mutex> lock(task->mutex);
+			task->finished.wait_for(lock, std::chrono::microseconds(200), [task] { return task->done.load(); });
+		}
+	}
+};
+
+class NativeJoin : public Callable
+{
+public:
+	Value call(Interpreter* interpreter, std::vector<Value> args) override
+	{
+		NativeTask::TaskInstance* task = nullptr;
+		if (args[0].tag == TypeTag::INSTANCE)
+			task = dynamic_cast<NativeTask::TaskInstance*>(std::get<std::shared_ptr<ToyInstance>>(args[0].data).get());
+		if (!task)
+			throw std::string("[ERROR] Function 'join' expects a task.\n");
+
+		NativeTask::await(task);
+		std::string output;
+		{
+			std::lock_guard<std::mutex> lock(task->mutex);
+			if (task->joinedBy == 0)
+				task->joinedBy = interpreter->contextId;
+			else if (task->joinedBy != interpreter->contextId)
+				throw std::string("[ERROR] Task was already joined by another task.\n");
+			output.swap(task->output);
+		}
+		interpreter->output->write(output);
+		if (!task->error.empty())
+			throw task->error;
+		Value result = task->resultFor(interpreter);
+		// Isolate results are unpacked into objects of the joiner already.
+		if (task->context != 0)
+			interpreter->adopt(result, { task->context });
+		return result;
+	}
+
+	int arity() override
+	{
+		return 1;
+	}
+
+	std::string name() override
+	{
+		return "join";
+	}
+};
@@ -0,0 +1,105 @@
+#include "Output.h"
+#include "Callable.hpp"
+#include "ToyClass.h"
+
+#include <cstring>
+
+Output::Output(FILE* file)
+	: file(file), buffer(new char[capacity]), used(0)
+{}
+
+Output::Output(Sink sink)
+	: file(nullptr), sink(sink), buffer(new char[capacity]), used(0)
+{}
+
+Output::~Output()
+{
+	flush();
+	delete[] buffer;
+}
+
+Output& Output::standard()
+{
+	static Output output(stdout);
+	return output;
+}
+
+void Output::write(const char* data, size_t size)
+{
+	if (used + size > capacity)
+	{
+		flush();
+		if (size >= capacity)
+		{
+			emit(data, size);
+			return;
+		}
+	}
+	memcpy(buffer + used, data, size);
+	used += size;
+}
+
+void Output::write(const std::string& str)
+{
+	write(str.data(), str.size());
+}
+
+void Output::write(char c)
+{
+	if (used == capacity)
+		flush();
+	buffer[used++] = c;
+}
+
+void Output::write(double num)
+{
+	char digits[32];
+	write(digits, formatNumber(num, digits));
+}
+
+void Output::write(const Value& val)
+{
+	switch (val.tag)
+	{
+	case TypeTag::BOOL:
+		if (std::get<bool>(val.data))
+			write("true", 4);
+		else
+			write("false", 5);
+		break;
+	case TypeTag::NUMBER:
+		write(std::get<double>(val.data));
+		break;
+	case TypeTag::STRING:
+		write(std::get<std::string>(val.data));
+		break;
+	case TypeTag::CALLABLE:
+		write(std::get<std::shared_ptr<Callable>>(val.data)->name());
+		break;
+	case TypeTag::INSTANCE:
+		write(std::get<std::shared_ptr<ToyInstance>>(val.data)->klass->name());
+		write(" instance", 9);
+		break;
+	default:
+		break;
+	}
+}
+
+void Output::emit(const char* data, size_t size)
+{
+	if (sink)
+		sink(data, size);
+	else
+		fwrite(data, 1, size, file);
+}
+
+void Output::flush()
+{
+	if (used > 0)
+	{
+		emit(buffer, used);
+		used = 0;
+	}
+	if (file)
+		fflush(file);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Value.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+// Buffered writer used by print and println, flushes when the buffer fills, before input and at exit.
+// Not thread safe, every interpreter running on its own thread needs its own Output.
+class Output
+{
+public:
+	// Receives the buffered bytes instead of a FILE, used by embedders to capture output.
+	typedef std::function<void(const char* data, size_t size)> Sink;
+
+private:
+	static constexpr size_t capacity = 1 << 16;
+	FILE* file;
+	Sink sink;
+	char* buffer;
+	size_t used;
+
+	void emit(const char* data, size_t size);
+
+public:
+	Output(FILE* file);
+	Output(Sink sink);
+	~Output();
+
+	static Output& standard();
+
+	void write(const char* data, size_t size);
+	void write(const std::string& str);
+	void write(char c);
+	void write(double num);
+	void write(const Value& val);
+	void flush();
+};
@@ -0,0 +1,140 @@
+#include "ParallelScanner.h"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+ParallelScanner::ParallelScanner(const char* source, size_t length)
+	: source(source), length(length)
+{}
+
+std::vector<ParallelScanner::Chunk> ParallelScanner::split(size_t count)
+{
+	std::vector<Chunk> chunks;
+	size_t target = std::max(length / count, MIN_CHUNK);
+	const char* end = source + length;
+	const char* chunkStart = source;
+	int chunkLine = 1;
+	const char* boundary = length > target ? source + target : end;
+
+	// Walks the source with the same string and comment rules as Scanner, p is always in plain code.
+	const char* p = source;
+	int line = 1;
+	while (p < end)
+	{
+		int newlines = 0;
+		const char* special = simd::findEither(p, end, '"', '/', newlines);
+		if (boundary < end && special > boundary)
+		{
+			const char* from = std::max(p, boundary);
+			const char* newline = (const char*)memchr(from, '\n', special - from);
+			if (newline)
+			{
+				const char* splitAt = newline + 1;
+				int splitLine = line + (int)std::count(p, splitAt, '\n');
+				chunks.push_back({ chunkStart, (size_t)(splitAt - chunkStart), chunkLine });
+				chunkStart = splitAt;
+				chunkLine = splitLine;
+				boundary = (size_t)(end - splitAt) > target ? splitAt + target : end;
+				p = splitAt;
+				line = splitLine;
+				continue;
+			}
+		}
+
+		line += newlines;
+		p = special;
+		if (p == end)
+			break;
+
+		if (*p == '"')
+		{
+			p++;
+			while (true)
+			{
+				newlines = 0;
+				p = simd::findEither(p, end, '"', '\\', newlines);
+				line += newlines;
+				if (p == end || *p == '"')
+					break;
+				if (p + 1 < end && p[1] == '\n')
+					line++;
+				p = p + 2 < end ? p + 2 : end;
+			}
+			if (p < end)
+				p++;
+		}
+		else if (p + 1 < end && p[1] == '/')
+		{
+			const char* newline = (const char*)memchr(p, '\n', end - p);
+			p = newline ? newline : end;
+		}
+		else if (p + 1 < end && p[1] == '*')
+		{
+			p += 2;
+			while (true)
+			{
+				newlines = 0;
+				p = simd::findEither(p, end, '*', '*', newlines);
+				line += newlines;
+				if (p == end)
+					break;
+				if (p + 1 < end && p[1] == '/')
+				{
+					p += 2;
+					break;
+				}
+				p++;
+			}
+		}
+		else
+		{
+			p++;
+		}
+	}
+
+	chunks.push_back({ chunkStart, (size_t)(end - chunkStart), chunkLine });
+	return chunks;
+}
+
+std::vector<Token> ParallelScanner::scanTokens(ThreadPool& pool)
+{
+	// A few pieces per worker keeps the threads busy when some pieces lex slower than others.
+	std::vector<Chunk> chunks = split(pool.size() * 4);
+	if (chunks.size() == 1)
+		return Scanner(source, length).scanTokens();
+
+	std::vector<std::vector<Token>> pieces(chunks.size());
+	std::atomic<size_t> remaining(chunks.size());
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		pool.submit([&chunks, &pieces, &remaining, i]() {
+			Scanner scanner(chunks[i].start, chunks[i].length, chunks[i].line);
+			pieces[i] = scanner.scanTokens();
+			remaining--;
+		});
+	}
+	// Only waits for these pieces and helps with them, the pool may be running unrelated tasks and
+	// this may be one of its workers.
+	while (remaining > 0)
+	{
+		if (!pool.runPending())
+			std::this_thread::yield();
+	}
+
+	size_t total = 0;
+	for (auto& piece : pieces)
+		total += piece.size();
+
+	// Every piece ends with an EOF token, only the last one is kept.
+	std::vector<Token> tokens;
+	tokens.reserve(total - pieces.size() + 1);
+	for (size_t i = 0; i < pieces.size(); i++)
+	{
+		auto last = i + 1 == pieces.size() ? pieces[i].end() : pieces[i].end() - 1;
+		tokens.insert(tokens.end(), pieces[i].begin(), last);
+	}
+	return tokens;
+}
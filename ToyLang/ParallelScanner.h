@@ -0,0 +1,30 @@
+#pragma once
+#include "Scanner.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+// Splits a large source at newlines outside of strings and block comments and
+// scans the pieces on a thread pool, producing the same tokens as Scanner.
+class ParallelScanner
+{
+private:
+	struct Chunk
+	{
+		const char* start;
+		size_t length;
+		int line;
+	};
+
+	// Pieces smaller than this are not worth a task.
+	static constexpr size_t MIN_CHUNK = 1 << 18;
+
+	const char* source;
+	size_t length;
+
+	std::vector<Chunk> split(size_t count);
+
+public:
+	ParallelScanner(const char* source, size_t length);
+	std::vector<Token> scanTokens(ThreadPool& pool);
+};
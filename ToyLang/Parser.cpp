@@ -2,10 +2,24 @@
 #include "AST.h"
 #include "Value.h"
 
-Parser::Parser(std::vector<Token>& tokens)
-	: tokens(tokens), currentToken(0)
+#include <algorithm>
+#include <array>
+
+Parser::Parser(Scanner& scanner, bool lazyBodies)
+	: scanner(&scanner), tokens(nullptr), ring(LOOKAHEAD, Token(TokenType::EOF_TOKEN, 0, "", 0)), currentToken(0), scanned(0), lazyBodies(lazyBodies)
+{}
+
+Parser::Parser(std::vector<Token>& tokens, bool lazyBodies)
+	: scanner(nullptr), tokens(&tokens), ring(LOOKAHEAD, Token(TokenType::EOF_TOKEN, 0, "", 0)), currentToken(0), scanned(0), lazyBodies(lazyBodies)
 {}
 
+Token Parser::pull()
+{
+	if (scanner)
+		return scanner->scanToken();
+	return (*tokens)[std::min(scanned, tokens->size() - 1)];
+}
+
 std::vector<std::unique_ptr<Stmt>> Parser::parse()
 {
 	std::vector<std::unique_ptr<Stmt>> root;
@@ -42,7 +56,7 @@ std::unique_ptr<Stmt> Parser::decleration()
 		return varDecl();
 	}
 
-	std::cout << "[ERROR] Invalid token '" << token.getLexeme() << "' at line: " << token.line << std::endl;
+	*errors << "[ERROR] Invalid token '" << token.getLexeme() << "' at line: " << token.line << std::endl;
 	return nullptr;
 }
 
@@ -63,13 +77,122 @@ std::unique_ptr<StmtFunction> Parser::function(std::string type)
 
 	consume(TokenType::OPEN_BRACE, "Expect '{' at " + type + " start.");
 
+	if (lazyBodies)
+	{
+		std::unique_ptr<StmtFunction> func = std::make_unique<StmtFunction>(name, std::vector<std::unique_ptr<Stmt>>(), params);
+		skipBody(func.get());
+		lazyFunctions.push_back(func.get());
+		return func;
+	}
+
+	bool outerYield = sawYield;
+	sawYield = false;
+	functionDepth++;
 	std::vector<std::unique_ptr<Stmt>> body;
 	while (!match(TokenType::CLOSE_BRACE))
 	{
 		body.push_back(std::move(statement()));
 	}
+	functionDepth--;
+
+	std::unique_ptr<StmtFunction> func = std::make_unique<StmtFunction>(name, std::move(body), params);
+	func->generator = sawYield;
+	sawYield = outerYield;
+	return func;
+}
+
+void Parser::skipBody(StmtFunction* func)
+{
+	// The range is taken from the braces, string literal tokens point into a copy of their text.
+	Token open = consumed();
+	TokenType previous = TokenType::OPEN_BRACE;
+	int depth = 1;
+	while (depth > 0)
+	{
+		Token& token = advance();
+		switch (token.type)
+		{
+		case TokenType::OPEN_BRACE:
+			depth++;
+			break;
+		case TokenType::CLOSE_BRACE:
+			depth--;
+			break;
+		case TokenType::IDENTIFIER:
+			// The resolver has to know about every assigned name before binding intrinsics.
+			switch (peek().type)
+			{
+			case TokenType::EQUAL:
+			case TokenType::PLUS_EQUAL:
+			case TokenType::MINUS_EQUAL:
+			case TokenType::STAR_EQUAL:
+			case TokenType::SLASH_EQUAL:
+				if (previous != TokenType::DOT)
+					bodyAssignments.insert(token.getLexeme());
+				break;
+			default:
+				break;
+			}
+			break;
+		case TokenType::EOF_TOKEN:
+			*errors << "[ERROR line: " << token.line << "] Expect '}' at the end of '" << func->name.getLexeme() << "'." << std::endl;
+			hadError = true;
+			throw true;
+		default:
+			break;
+		}
+		previous = token.type;
+	}
+
+	func->lazy = true;
+	func->bodyStart = open.start + 1;
+	func->bodyLength = consumed().start - func->bodyStart;
+	func->bodyLine = open.line;
+}
+
+bool Parser::parseBody(StmtFunction* func, std::ostream& errors)
+{
+	Scanner scanner(func->bodyStart, func->bodyLength, func->bodyLine);
+	Parser parser(scanner);
+	parser.errors = &errors;
+	parser.functionDepth = 1;
+	std::vector<std::unique_ptr<Stmt>> body;
+	while (!parser.match(TokenType::EOF_TOKEN))
+	{
+		try
+		{
+			body.push_back(parser.statement());
+		}
+		catch (bool err)
+		{
+			parser.hadError = true;
+		}
+	}
+
+	func->stmts = std::move(body);
+	func->generator = parser.sawYield;
+	return !parser.hadError;
+}
+
+bool Parser::checkBody(const StmtFunction* func, std::ostream& errors)
+{
+	Scanner scanner(func->bodyStart, func->bodyLength, func->bodyLine);
+	Parser parser(scanner);
+	parser.errors = &errors;
+	parser.functionDepth = 1;
+	while (!parser.match(TokenType::EOF_TOKEN))
+	{
+		try
+		{
+			parser.checkStatement();
+		}
+		catch (bool err)
+		{
+			parser.hadError = true;
+		}
+	}
 
-	return std::make_unique<StmtFunction>(name, std::move(body), params);
+	return !parser.hadError;
 }
 
 std::unique_ptr<StmtVarDecl> Parser::varDecl()
@@ -133,6 +256,11 @@ std::unique_ptr<Stmt> Parser::statement()
 		consume(TokenType::SEMI_COLON, "Expect ';' after a return statement.");
 		return std::make_unique<StmtReturn>(std::move(expr));
 	}
+	else if (peek().type == TokenType::YIELD)
+	{
+		advance();
+		return std::move(yieldStatement());
+	}
 	else if (peek().type != TokenType::SEMI_COLON)
 	{
 		auto expr = parseExpr();
@@ -182,11 +310,20 @@ std::unique_ptr<StmtWhile> Parser::whileStatement()
 	return std::make_unique<StmtWhile>(std::move(cond), paren, std::move(then));
 }
 
-std::unique_ptr<StmtBlock> Parser::forStatement()
+std::unique_ptr<Stmt> Parser::forStatement()
 {
 	consume(TokenType::OPEN_PAREN, "Expect '(' after 'for'.");
 	Token paren = consumed();
 
+	if (peek().type == TokenType::IDENTIFIER && peekNext().type == TokenType::IN)
+	{
+		Token name = advance();
+		advance();
+		std::unique_ptr<Expr> iterable = parseExpr();
+		consume(TokenType::CLOSE_PAREN, "Expect ')' after the iterated expression of 'for'.");
+		return std::make_unique<StmtForIn>(name, std::move(iterable), statement());
+	}
+
 	std::unique_ptr<Stmt> decl = nullptr;
 	if (match(TokenType::VAR))
 		decl = varDecl();
@@ -230,211 +367,364 @@ std::unique_ptr<StmtBlock> Parser::forStatement()
 	return std::make_unique<StmtBlock>(std::move(bodyStmts));
 }
 
-std::unique_ptr<Expr> Parser::parseExpr()
-{
-	return std::move(assignment());
-}
-
-std::unique_ptr<Expr> Parser::assignment()
+void Parser::checkStatement()
 {
-	std::unique_ptr<Expr> expr = logic_or();
-
-	if (match({ TokenType::EQUAL, TokenType::PLUS_EQUAL, TokenType::MINUS_EQUAL, TokenType::STAR_EQUAL, TokenType::SLASH_EQUAL }))
+	switch (peek().type)
 	{
-		Token op = consumed();
-		std::unique_ptr<Expr> asgn = std::move(parseExpr());
-
-		if (expr->instance == ExprType::VariableGet)
+	case TokenType::SEMI_COLON:
+		// An empty statement, statement() leaves the ';' as well.
+		break;
+	case TokenType::VAR:
+		advance();
+		advance();
+		if (match(TokenType::EQUAL))
+			checkPrecedence(Precedence::ASSIGNMENT);
+		consume(TokenType::SEMI_COLON, "Expect ';' after variable decleration.");
+		break;
+	case TokenType::IF:
+		advance();
+		consume(TokenType::OPEN_PAREN, "Expect '(' after 'if'.");
+		checkPrecedence(Precedence::ASSIGNMENT);
+		consume(TokenType::CLOSE_PAREN, "Expect ')' after if condition.");
+		checkStatement();
+		if (match(TokenType::ELSE))
+			checkStatement();
+		break;
+	case TokenType::WHILE:
+		advance();
+		consume(TokenType::OPEN_PAREN, "Expect '(' after 'while'.");
+		checkPrecedence(Precedence::ASSIGNMENT);
+		consume(TokenType::CLOSE_PAREN, "Expect ')' after while condition.");
+		checkStatement();
+		break;
+	case TokenType::FOR:
+		advance();
+		consume(TokenType::OPEN_PAREN, "Expect '(' after 'for'.");
+		if (peek().type == TokenType::IDENTIFIER && peekNext().type == TokenType::IN)
 		{
-			Token name = ((ExprVariableGet*)expr.get())->name;
-			return std::make_unique<ExprVariableSet>(name, std::move(asgn), op);
+			advance();
+			advance();
+			checkPrecedence(Precedence::ASSIGNMENT);
+			consume(TokenType::CLOSE_PAREN, "Expect ')' after the iterated expression of 'for'.");
+			checkStatement();
+			break;
 		}
-		else if (expr->instance == ExprType::MemberGet)
+		if (match(TokenType::VAR))
 		{
-			ExprMemberGet* get = (ExprMemberGet*)expr.get();
-			return std::make_unique<ExprMemberSet>(get->name, std::move(get->object), std::move(asgn), op);
+			advance();
+			if (match(TokenType::EQUAL))
+				checkPrecedence(Precedence::ASSIGNMENT);
+			consume(TokenType::SEMI_COLON, "Expect ';' after variable decleration.");
 		}
-		else if (expr->instance == ExprType::ArrayGet)
+		else if (!match(TokenType::SEMI_COLON))
 		{
-			ExprArrayGet* get = (ExprArrayGet*)expr.get();
-			return std::make_unique<ExprArraySet>(get->paren, std::move(get->object), std::move(get->index), std::move(asgn), op);
+			checkPrecedence(Precedence::ASSIGNMENT);
+			consume(TokenType::SEMI_COLON, "Expect ';' after decleration statement of 'for'.");
 		}
-		else
+		if (!match(TokenType::SEMI_COLON))
 		{
-			return this->errorAtToken("[ERROR] Invalid assignment target");
+			checkPrecedence(Precedence::ASSIGNMENT);
+			consume(TokenType::SEMI_COLON, "Expect ';' after an expression statement of 'for'.");
 		}
+		if (!match(TokenType::CLOSE_PAREN))
+		{
+			checkPrecedence(Precedence::ASSIGNMENT);
+			consume(TokenType::CLOSE_PAREN, "Expect ')' at the end of for statement conditions.");
+		}
+		checkStatement();
+		break;
+	case TokenType::OPEN_BRACE:
+		advance();
+		while (!match(TokenType::CLOSE_BRACE))
+			checkStatement();
+		break;
+	case TokenType::RETURN:
+		advance();
+		checkPrecedence(Precedence::ASSIGNMENT);
+		consume(TokenType::SEMI_COLON, "Expect ';' after a return statement.");
+		break;
+	case TokenType::YIELD:
+		advance();
+		checkPrecedence(Precedence::ASSIGNMENT);
+		consume(TokenType::SEMI_COLON, "Expect ';' after a yield statement.");
+		break;
+	default:
+		checkPrecedence(Precedence::ASSIGNMENT);
+		consume(TokenType::SEMI_COLON, "Expect ';' after an expression statement.");
+		break;
 	}
+}
 
-	return std::move(expr);
+const Parser::ParseRule& Parser::getRule(TokenType type)
+{
+	static const std::array<ParseRule, RULE_COUNT> rules = []() {
+		std::array<ParseRule, RULE_COUNT> table{};
+		auto set = [&](TokenType type, PrefixFn prefix, InfixFn infix, Precedence precedence) {
+			table[(size_t)type] = { prefix, infix, precedence };
+		};
+
+		set(TokenType::EQUAL, nullptr, &Parser::assignment, Precedence::ASSIGNMENT);
+		set(TokenType::PLUS_EQUAL, nullptr, &Parser::assignment, Precedence::ASSIGNMENT);
+		set(TokenType::MINUS_EQUAL, nullptr, &Parser::assignment, Precedence::ASSIGNMENT);
+		set(TokenType::STAR_EQUAL, nullptr, &Parser::assignment, Precedence::ASSIGNMENT);
+		set(TokenType::SLASH_EQUAL, nullptr, &Parser::assignment, Precedence::ASSIGNMENT);
+		set(TokenType::OR, nullptr, &Parser::binary, Precedence::OR);
+		set(TokenType::AND, nullptr, &Parser::binary, Precedence::AND);
+		set(TokenType::EQUAL_EQUAL, nullptr, &Parser::binary, Precedence::EQUALITY);
+		set(TokenType::BANG_EQUAL, nullptr, &Parser::binary, Precedence::EQUALITY);
+		set(TokenType::LESS, nullptr, &Parser::binary, Precedence::COMPARISON);
+		set(TokenType::GREAT, nullptr, &Parser::binary, Precedence::COMPARISON);
+		set(TokenType::LESS_EQUAL, nullptr, &Parser::binary, Precedence::COMPARISON);
+		set(TokenType::GREAT_EQUAL, nullptr, &Parser::binary, Precedence::COMPARISON);
+		set(TokenType::PLUS, nullptr, &Parser::binary, Precedence::TERM);
+		set(TokenType::MINUS, &Parser::unary, &Parser::binary, Precedence::TERM);
+		set(TokenType::STAR, nullptr, &Parser::binary, Precedence::FACTOR);
+		set(TokenType::SLASH, nullptr, &Parser::binary, Precedence::FACTOR);
+		set(TokenType::BANG, &Parser::unary, nullptr, Precedence::NONE);
+		set(TokenType::OPEN_PAREN, &Parser::grouping, &Parser::call, Precedence::CALL);
+		set(TokenType::DOT, nullptr, &Parser::member, Precedence::CALL);
+		set(TokenType::OPEN_BRACKET, nullptr, &Parser::index, Precedence::CALL);
+		set(TokenType::TRUE, &Parser::literal, nullptr, Precedence::NONE);
+		set(TokenType::FALSE, &Parser::literal, nullptr, Precedence::NONE);
+		set(TokenType::NUMBER_LITERAL, &Parser::literal, nullptr, Precedence::NONE);
+		set(TokenType::STRING_LITERAL, &Parser::literal, nullptr, Precedence::NONE);
+		set(TokenType::IDENTIFIER, &Parser::variable, nullptr, Precedence::NONE);
+		set(TokenType::SELF, &Parser::variable, nullptr, Precedence::NONE);
+		set(TokenType::SPAWN, &Parser::spawn, nullptr, Precedence::NONE);
+		return table;
+	}();
+	return rules[(size_t)type];
 }
 
-std::unique_ptr<Expr> Parser::logic_or()
+std::unique_ptr<StmtYield> Parser::yieldStatement()
 {
-	std::unique_ptr<Expr> lhs = logic_and();
-	while (match(TokenType::OR))
+	Token keyword = consumed();
+	if (functionDepth == 0)
 	{
-		Token op = consumed();
-		std::unique_ptr<Expr> rhs = logic_and();
-		lhs = std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
+		errorAtToken("'yield' is only allowed inside a function.");
+		return nullptr;
 	}
+	sawYield = true;
+	std::unique_ptr<Expr> expr = parseExpr();
+	consume(TokenType::SEMI_COLON, "Expect ';' after a yield statement.");
+	return std::make_unique<StmtYield>(keyword, std::move(expr));
+}
 
-	return std::move(lhs);
+std::unique_ptr<Expr> Parser::parseExpr()
+{
+	return parsePrecedence(Precedence::ASSIGNMENT);
 }
 
-std::unique_ptr<Expr> Parser::logic_and()
+std::unique_ptr<Expr> Parser::parsePrecedence(Precedence precedence)
 {
-	std::unique_ptr<Expr> lhs = equality();
-	while (match(TokenType::AND))
+	PrefixFn prefix = getRule(advance().type).prefix;
+	if (!prefix)
+		return errorAtToken("Invalid identifier.");
+
+	std::unique_ptr<Expr> expr = (this->*prefix)();
+	while (precedence <= getRule(peek().type).precedence)
 	{
-		Token op = consumed();
-		std::unique_ptr<Expr> rhs = equality();
-		lhs = std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
+		InfixFn infix = getRule(advance().type).infix;
+		expr = (this->*infix)(std::move(expr));
 	}
 
-	return std::move(lhs);
+	return expr;
 }
 
-std::unique_ptr<Expr> Parser::equality()
+std::unique_ptr<Expr> Parser::literal()
 {
-	std::unique_ptr<Expr> lhs = comparison();
-	while (match({ TokenType::EQUAL_EQUAL, TokenType::BANG_EQUAL }))
+	Token token = consumed();
+	switch (token.type)
 	{
-		Token op = consumed();
-		std::unique_ptr<Expr> rhs = comparison();
-		lhs = std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
+	case TokenType::TRUE:
+		return std::make_unique<ExprLiteral>(true);
+	case TokenType::FALSE:
+		return std::make_unique<ExprLiteral>(false);
+	case TokenType::NUMBER_LITERAL:
+		return std::make_unique<ExprLiteral>(token.getNumber());
+	default:
+		return std::make_unique<ExprLiteral>(token.getString());
 	}
+}
 
-	return std::move(lhs);
+std::unique_ptr<Expr> Parser::variable()
+{
+	return std::make_unique<ExprVariableGet>(consumed());
 }
 
-std::unique_ptr<Expr> Parser::comparison()
+std::unique_ptr<Expr> Parser::grouping()
 {
-	std::unique_ptr<Expr> lhs = addition();
-	while (match({ TokenType::LESS, TokenType::GREAT, TokenType::LESS_EQUAL, TokenType::GREAT_EQUAL }))
-	{
-		Token op = consumed();
-		std::unique_ptr<Expr> rhs = addition();
-		lhs = std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
-	}
+	std::unique_ptr<Expr> expr = parseExpr();
+	if (match(TokenType::CLOSE_PAREN))
+		return expr;
+	else
+		return errorAtToken("Expect ')' after a grouping expression.");
+}
+
+std::unique_ptr<Expr> Parser::unary()
+{
+	Token op = consumed();
+	std::unique_ptr<Expr> expr = parsePrecedence(Precedence::UNARY);
+	return std::make_unique<ExprUnary>(std::move(expr), op);
+}
 
-	return std::move(lhs);
+std::unique_ptr<Expr> Parser::binary(std::unique_ptr<Expr> lhs)
+{
+	// Binary operators are left associative, so the right side only takes tighter operators.
+	Token op = consumed();
+	Precedence next = (Precedence)((int)getRule(op.type).precedence + 1);
+	std::unique_ptr<Expr> rhs = parsePrecedence(next);
+	return std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
 }
 
-std::unique_ptr<Expr> Parser::addition()
+std::unique_ptr<Expr> Parser::assignment(std::unique_ptr<Expr> target)
 {
-	std::unique_ptr<Expr> lhs = multiplication();
-	while (match({ TokenType::PLUS, TokenType::MINUS }))
+	Token op = consumed();
+	std::unique_ptr<Expr> asgn = parseExpr();
+
+	if (target->instance == ExprType::VariableGet)
 	{
-		Token op = consumed();
-		std::unique_ptr<Expr> rhs = multiplication();
-		lhs = std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
+		Token name = ((ExprVariableGet*)target.get())->name;
+		return std::make_unique<ExprVariableSet>(name, std::move(asgn), op);
+	}
+	else if (target->instance == ExprType::MemberGet)
+	{
+		ExprMemberGet* get = (ExprMemberGet*)target.get();
+		return std::make_unique<ExprMemberSet>(get->name, std::move(get->object), std::move(asgn), op);
+	}
+	else if (target->instance == ExprType::ArrayGet)
+	{
+		ExprArrayGet* get = (ExprArrayGet*)target.get();
+		return std::make_unique<ExprArraySet>(get->paren, std::move(get->object), std::move(get->index), std::move(asgn), op);
+	}
+	else
+	{
+		return this->errorAtToken("[ERROR] Invalid assignment target");
 	}
-
-	return std::move(lhs);
 }
 
-std::unique_ptr<Expr> Parser::multiplication()
+std::unique_ptr<Expr> Parser::call(std::unique_ptr<Expr> callee)
 {
-	std::unique_ptr<Expr> lhs = unary();
-	while (match({ TokenType::STAR, TokenType::SLASH }))
+	std::vector<std::unique_ptr<Expr>> args;
+	Token paren = consumed();
+	if (peek().type != TokenType::CLOSE_PAREN)
 	{
-		Token op = consumed();
-		std::unique_ptr<Expr> rhs = unary();
-		lhs = std::make_unique<ExprBinary>(std::move(lhs), std::move(rhs), op);
+		do
+		{
+			args.push_back(parseExpr());
+		} while (match(TokenType::COMMA));
 	}
+	consume(TokenType::CLOSE_PAREN, "Expect ')' after arguments.");
+	return std::make_unique<ExprCall>(std::move(callee), std::move(args), paren);
+}
 
-	return std::move(lhs);
+std::unique_ptr<Expr> Parser::member(std::unique_ptr<Expr> object)
+{
+	consume(TokenType::IDENTIFIER, "Expect an identifier as a member.");
+	Token mem = consumed();
+	return std::make_unique<ExprMemberGet>(mem, std::move(object));
 }
 
-std::unique_ptr<Expr> Parser::unary()
+std::unique_ptr<Expr> Parser::index(std::unique_ptr<Expr> object)
 {
-	if (match({ TokenType::MINUS, TokenType::BANG }))
-	{
-		Token op = consumed();
-		std::unique_ptr<Expr> expr = unary();
-		expr = std::make_unique<ExprUnary>(std::move(expr), op);
-		return std::move(expr);
-	}
-	else
-		return std::move(call());
+	Token paren = consumed();
+	std::unique_ptr<Expr> index = parseExpr();
+	consume(TokenType::CLOSE_BRACKET, "Expect ']' after an index of '['.");
+	return std::make_unique<ExprArrayGet>(paren, std::move(object), std::move(index));
 }
 
-std::unique_ptr<Expr> Parser::call()
+std::unique_ptr<Expr> Parser::spawn()
 {
-	std::unique_ptr<Expr> expr = primary();
+	Token keyword = consumed();
+	std::unique_ptr<Expr> call = parsePrecedence(Precedence::CALL);
+	if (!call || call->instance != ExprType::Call)
+		return errorAtToken("Expect a call after 'spawn'.");
+	return std::make_unique<ExprSpawn>(keyword, std::unique_ptr<ExprCall>((ExprCall*)call.release()));
+}
+
+ExprType Parser::checkPrecedence(Precedence precedence)
+{
+	TokenType type = advance().type;
+	if (!getRule(type).prefix)
+	{
+		errorAtToken("Invalid identifier.");
+		return ExprType::Literal;
+	}
 
-	while (true)
+	ExprType expr = ExprType::Literal;
+	switch (type)
 	{
-		if (match(TokenType::OPEN_PAREN)) {
-			std::vector<std::unique_ptr<Expr>> args;
-			std::unique_ptr<Expr> callee = std::move(expr);
-			Token paren = consumed();
+	case TokenType::MINUS:
+	case TokenType::BANG:
+		checkPrecedence(Precedence::UNARY);
+		expr = ExprType::Unary;
+		break;
+	case TokenType::OPEN_PAREN:
+		expr = checkPrecedence(Precedence::ASSIGNMENT);
+		if (!match(TokenType::CLOSE_PAREN))
+			errorAtToken("Expect ')' after a grouping expression.");
+		break;
+	case TokenType::IDENTIFIER:
+	case TokenType::SELF:
+		expr = ExprType::VariableGet;
+		break;
+	case TokenType::SPAWN:
+		if (checkPrecedence(Precedence::CALL) != ExprType::Call)
+			errorAtToken("Expect a call after 'spawn'.");
+		expr = ExprType::Spawn;
+		break;
+	default:
+		break;
+	}
+
+	while (precedence <= getRule(peek().type).precedence)
+	{
+		TokenType op = advance().type;
+		switch (op)
+		{
+		case TokenType::EQUAL:
+		case TokenType::PLUS_EQUAL:
+		case TokenType::MINUS_EQUAL:
+		case TokenType::STAR_EQUAL:
+		case TokenType::SLASH_EQUAL:
+			checkPrecedence(Precedence::ASSIGNMENT);
+			if (expr != ExprType::VariableGet && expr != ExprType::MemberGet && expr != ExprType::ArrayGet)
+				errorAtToken("[ERROR] Invalid assignment target");
+			expr = ExprType::VariableSet;
+			break;
+		case TokenType::OPEN_PAREN:
 			if (peek().type != TokenType::CLOSE_PAREN)
 			{
 				do
 				{
-					args.push_back(parseExpr());
+					checkPrecedence(Precedence::ASSIGNMENT);
 				} while (match(TokenType::COMMA));
 			}
 			consume(TokenType::CLOSE_PAREN, "Expect ')' after arguments.");
-			expr = std::make_unique<ExprCall>(std::move(callee), std::move(args), paren);
-		}
-		else if (match(TokenType::DOT))
-		{
+			expr = ExprType::Call;
+			break;
+		case TokenType::DOT:
 			consume(TokenType::IDENTIFIER, "Expect an identifier as a member.");
-			Token mem = consumed();
-			expr = std::make_unique<ExprMemberGet>(mem, std::move(expr));
-		}
-		else if (match(TokenType::OPEN_BRACKET))
-		{
-			Token paren = consumed();
-			std::unique_ptr<Expr> index = parseExpr();
+			expr = ExprType::MemberGet;
+			break;
+		case TokenType::OPEN_BRACKET:
+			checkPrecedence(Precedence::ASSIGNMENT);
 			consume(TokenType::CLOSE_BRACKET, "Expect ']' after an index of '['.");
-			expr = std::make_unique<ExprArrayGet>(paren, std::move(expr), std::move(index));
-		}
-		else
-		{
+			expr = ExprType::ArrayGet;
+			break;
+		default:
+			checkPrecedence((Precedence)((int)getRule(op).precedence + 1));
+			expr = ExprType::Binary;
 			break;
 		}
 	}
 
-	return std::move(expr);
-}
-
-std::unique_ptr<Expr> Parser::primary()
-{
-	Token token = advance();
-
-	switch (token.type)
-	{
-	case TokenType::TRUE:
-		return std::make_unique<ExprLiteral>(true);
-	case TokenType::FALSE:
-		return std::make_unique<ExprLiteral>(false);
-	case TokenType::NUMBER_LITERAL:
-		return std::make_unique<ExprLiteral>(token.getNumber());
-	case TokenType::STRING_LITERAL:
-		return std::make_unique<ExprLiteral>(token.getString());
-	case TokenType::OPEN_PAREN:
-	{
-		std::unique_ptr<Expr> expr = parseExpr();
-		if (match(TokenType::CLOSE_PAREN))
-			return std::move(expr);
-		else
-			return errorAtToken("Expect ')' after a grouping expression.");
-	}
-	case TokenType::IDENTIFIER:
-		return std::make_unique<ExprVariableGet>(token);
-	case TokenType::SELF:
-		return std::make_unique<ExprVariableGet>(token);
-	default:
-		return errorAtToken("Invalid identifier.");
-	}
+	return expr;
 }
 
 void Parser::consume(TokenType type, std::string msg)
 {
-	if (tokens[currentToken].type == type)
+	if (peek().type == type)
 	{
 		advance();
 	}
@@ -446,7 +736,7 @@ void Parser::consume(TokenType type, std::string msg)
 
 void Parser::panic()
 {
-	TokenType type = tokens[currentToken].type;
+	TokenType type = peek().type;
 	while (type != TokenType::EOF_TOKEN)
 	{
 		if (type == TokenType::SEMI_COLON)
@@ -463,6 +753,7 @@ void Parser::panic()
 		case TokenType::WHILE:
 		case TokenType::FOR:
 		case TokenType::RETURN:
+		case TokenType::YIELD:
 			return;
 
 		default:
@@ -5,22 +5,58 @@
 
 #include <iostream>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 class Parser
 {
 private:
-    std::vector<Token>& tokens;
+    // Tokens are pulled on demand into a small ring, only the last consumed token
+    // and the lookahead are kept so memory does not grow with the token count.
+    static constexpr size_t LOOKAHEAD = 8;
+    Scanner* scanner;
+    std::vector<Token>* tokens;
+    std::vector<Token> ring;
     size_t currentToken;
+    size_t scanned;
+    bool lazyBodies;
+    // Function bodies being parsed, and whether the innermost one has a yield so far.
+    int functionDepth = 0;
+    bool sawYield = false;
+
+    Token pull();
+    inline Token& token(size_t index)
+    {
+        while (scanned <= index)
+        {
+            Token next = pull();
+            ring[scanned & (LOOKAHEAD - 1)] = next;
+            scanned++;
+        }
+        return ring[index & (LOOKAHEAD - 1)];
+    }
 
 public:
     bool hadError = false;
+    // Syntax errors are reported here.
+    std::ostream* errors = &std::cout;
+    // Functions whose bodies were skimmed, and the names assigned inside those bodies.
+    std::vector<StmtFunction*> lazyFunctions;
+    std::unordered_set<std::string> bodyAssignments;
 
-    Parser(std::vector<Token>& tokens);
+    // With lazyBodies set function bodies are only brace matched, see parseBody().
+    Parser(Scanner& scanner, bool lazyBodies = false);
+    Parser(std::vector<Token>& tokens, bool lazyBodies = false);
+    // Parses a skimmed body from its source range, returns false on syntax errors.
+    // Leaves lazy set, Interpreter::buildBody() clears it once the body is ready to run.
+    static bool parseBody(StmtFunction* func, std::ostream& errors = std::cout);
+    // Reports the syntax errors parseBody() would, without building anything. Returns false on errors.
+    static bool checkBody(const StmtFunction* func, std::ostream& errors = std::cout);
     std::vector<std::unique_ptr<Stmt>> parse();
 
     std::unique_ptr<Stmt> decleration();
     std::unique_ptr<StmtFunction> function(std::string type);
+    void skipBody(StmtFunction* func);
     std::unique_ptr<StmtVarDecl> varDecl();
     std::unique_ptr<StmtClass> classDecl();
 
@@ -28,39 +64,77 @@ public:
     std::unique_ptr<StmtBlock> block();
     std::unique_ptr<StmtIf> ifStatement();
     std::unique_ptr<StmtWhile> whileStatement();
-    std::unique_ptr<StmtBlock> forStatement();
+    std::unique_ptr<Stmt> forStatement();
+    std::unique_ptr<StmtYield> yieldStatement();
 
     std::unique_ptr<Expr> parseExpr();
-    std::unique_ptr<Expr> assignment();
-    std::unique_ptr<Expr> logic_or();
-    std::unique_ptr<Expr> logic_and();
-    std::unique_ptr<Expr> equality();
-    std::unique_ptr<Expr> comparison();
-    std::unique_ptr<Expr> addition();
-    std::unique_ptr<Expr> multiplication();
+
+private:
+    // Expressions are parsed by precedence climbing over a table of handlers indexed by TokenType.
+    enum class Precedence
+    {
+        NONE,
+        ASSIGNMENT,
+        OR,
+        AND,
+        EQUALITY,
+        COMPARISON,
+        TERM,
+        FACTOR,
+        UNARY,
+        CALL
+    };
+
+    typedef std::unique_ptr<Expr> (Parser::*PrefixFn)();
+    typedef std::unique_ptr<Expr> (Parser::*InfixFn)(std::unique_ptr<Expr> lhs);
+
+    struct ParseRule
+    {
+        PrefixFn prefix;
+        InfixFn infix;
+        Precedence precedence;
+    };
+
+    static constexpr size_t RULE_COUNT = (size_t)TokenType::EOF_TOKEN + 1;
+    static const ParseRule& getRule(TokenType type);
+
+    std::unique_ptr<Expr> parsePrecedence(Precedence precedence);
+    std::unique_ptr<Expr> literal();
+    std::unique_ptr<Expr> variable();
+    std::unique_ptr<Expr> grouping();
     std::unique_ptr<Expr> unary();
-    std::unique_ptr<Expr> call();
-    std::unique_ptr<Expr> primary();
+    std::unique_ptr<Expr> binary(std::unique_ptr<Expr> lhs);
+    std::unique_ptr<Expr> assignment(std::unique_ptr<Expr> target);
+    std::unique_ptr<Expr> call(std::unique_ptr<Expr> callee);
+    std::unique_ptr<Expr> member(std::unique_ptr<Expr> object);
+    std::unique_ptr<Expr> index(std::unique_ptr<Expr> object);
+    std::unique_ptr<Expr> spawn();
 
+    // Syntax only mirrors of statement() and parsePrecedence(), an expression is only known by the
+    // kind of node it would become so assignment targets and spawn can be checked.
+    void checkStatement();
+    ExprType checkPrecedence(Precedence precedence);
+
+public:
     inline Token& advance()
     {
-        return this->tokens[this->currentToken++];
+        return token(this->currentToken++);
     }
-    inline Token& consumed() const
+    inline Token& consumed()
     {
-        return this->tokens[this->currentToken - 1];
+        return token(this->currentToken - 1);
     }
-    inline Token& peek() const
+    inline Token& peek()
     {
-        return this->tokens[this->currentToken];
+        return token(this->currentToken);
     }
-    inline Token& peekNext() const
+    inline Token& peekNext()
     {
-        return this->tokens[this->currentToken + 1];
+        return token(this->currentToken + 1);
     }
     bool match(TokenType type)
     {
-        TokenType next = tokens[currentToken].type;
+        TokenType next = peek().type;
         if (next == type)
         {
             currentToken++;
@@ -69,29 +143,20 @@ public:
 
         return false;
     }
-    bool match(std::vector<TokenType> types)
-    {
-        for (auto& token : types)
-        {
-            if (match(token))
-                return true;
-        }
-        return false;
-    }
     void consume(TokenType type, std::string msg);
 
 	void panic();
 
     inline std::unique_ptr<Expr> error(std::string message)
     {
-        std::cout << message << std::endl;
+        *errors << message << std::endl;
         this->panic();
         hadError = true;
         return nullptr;
     }
     inline std::unique_ptr<Expr> errorAtToken(std::string message)
     {
-        std::cout << "[ERROR line: " << tokens[currentToken].line << "] " << message << std::endl;
+        *errors << "[ERROR line: " << peek().line << "] " << message << std::endl;
         this->panic();
         hadError = true;
         return nullptr;
@@ -0,0 +1,236 @@
+#include "Resolver.h"
+
+#include <unordered_map>
+
+struct IntrinsicInfo
+{
+	Intrinsic type;
+	size_t arity;
+};
+
+static const std::unordered_map<std::string, IntrinsicInfo> intrinsics = {
+	{ "print", { Intrinsic::PRINT, 1 } },
+	{ "println", { Intrinsic::PRINTLN, 1 } },
+	{ "flush", { Intrinsic::FLUSH, 0 } },
+	{ "input", { Intrinsic::INPUT, 0 } },
+	{ "clock", { Intrinsic::CLOCK, 0 } },
+	{ "now", { Intrinsic::NOW, 0 } },
+	{ "str", { Intrinsic::STR, 1 } },
+	{ "num", { Intrinsic::NUM, 1 } },
+	{ "sqrt", { Intrinsic::SQRT, 1 } },
+	{ "floor", { Intrinsic::FLOOR, 1 } },
+	{ "abs", { Intrinsic::ABS, 1 } },
+	{ "min", { Intrinsic::MIN, 2 } },
+	{ "max", { Intrinsic::MAX, 2 } },
+	{ "sin", { Intrinsic::SIN, 1 } },
+	{ "cos", { Intrinsic::COS, 1 } },
+	{ "pow", { Intrinsic::POW, 2 } },
+};
+
+Resolver::Resolver(std::vector<Stmt*> root)
+	: root(root), collecting(false)
+{}
+
+void Resolver::resolve()
+{
+	// First pass finds the globals that are assigned anywhere, those can not be bound statically.
+	collecting = true;
+	for (auto& stmt : root)
+		stmt->accept(this);
+
+	collecting = false;
+	for (auto& stmt : root)
+		stmt->accept(this);
+}
+
+void Resolver::assumeReassigned(const std::unordered_set<std::string>& names)
+{
+	reassigned.insert(names.begin(), names.end());
+}
+
+void Resolver::resolveBody(StmtFunction* stmt)
+{
+	collecting = false;
+	scopes.clear();
+	function(stmt);
+}
+
+void Resolver::declare(Token name)
+{
+	if (!scopes.empty())
+		scopes.back().insert(name.getLexeme());
+	else
+		declaredGlobals.insert(name.getLexeme());
+}
+
+bool Resolver::isShadowed(const std::string& name)
+{
+	if (reassigned.find(name) != reassigned.end() || declaredGlobals.find(name) != declaredGlobals.end())
+		return true;
+	for (auto& scope : scopes)
+	{
+		if (scope.find(name) != scope.end())
+			return true;
+	}
+	return false;
+}
+
+Value Resolver::visit(ExprBinary* expr)
+{
+	expr->lhs->accept(this);
+	expr->rhs->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprUnary* expr)
+{
+	expr->rhs->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprLiteral*)
+{
+	return Value();
+}
+
+Value Resolver::visit(ExprVariableGet*)
+{
+	return Value();
+}
+
+Value Resolver::visit(ExprVariableSet* expr)
+{
+	if (collecting)
+		reassigned.insert(expr->name.getLexeme());
+	expr->setVal->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprCall* expr)
+{
+	expr->callee->accept(this);
+	for (auto& a : expr->args)
+		a->accept(this);
+
+	if (!collecting && expr->callee->instance == ExprType::VariableGet)
+	{
+		std::string name = ((ExprVariableGet*)expr->callee.get())->name.getLexeme();
+		auto it = intrinsics.find(name);
+		if (it != intrinsics.end() && it->second.arity == expr->args.size() && !isShadowed(name))
+			expr->intrinsic = it->second.type;
+	}
+	return Value();
+}
+
+Value Resolver::visit(ExprMemberGet* expr)
+{
+	expr->object->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprMemberSet* expr)
+{
+	expr->object->accept(this);
+	expr->val->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprArrayGet* expr)
+{
+	expr->object->accept(this);
+	expr->index->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprArraySet* expr)
+{
+	expr->object->accept(this);
+	expr->index->accept(this);
+	expr->val->accept(this);
+	return Value();
+}
+
+Value Resolver::visit(ExprSpawn* expr)
+{
+	// The call goes through its callee value when spawned, so it is never bound to an intrinsic.
+	expr->call->callee->accept(this);
+	for (auto& a : expr->call->args)
+		a->accept(this);
+	return Value();
+}
+
+void Resolver::visit(StmtExpr* stmt)
+{
+	stmt->expr->accept(this);
+}
+
+void Resolver::function(StmtFunction* stmt)
+{
+	scopes.emplace_back();
+	for (auto& p : stmt->params)
+		declare(p);
+	for (auto& s : stmt->stmts)
+		s->accept(this);
+	scopes.pop_back();
+}
+
+void Resolver::visit(StmtFunction* stmt)
+{
+	declare(stmt->name);
+	function(stmt);
+}
+
+void Resolver::visit(StmtVarDecl* stmt)
+{
+	if (stmt->initVal)
+		stmt->initVal->accept(this);
+	declare(stmt->name);
+}
+
+void Resolver::visit(StmtBlock* stmt)
+{
+	scopes.emplace_back();
+	for (auto& s : stmt->stmts)
+		s->accept(this);
+	scopes.pop_back();
+}
+
+void Resolver::visit(StmtIf* stmt)
+{
+	stmt->cond->accept(this);
+	stmt->then->accept(this);
+	if (stmt->els)
+		stmt->els->accept(this);
+}
+
+void Resolver::visit(StmtWhile* stmt)
+{
+	stmt->cond->accept(this);
+	stmt->then->accept(this);
+}
+
+void Resolver::visit(StmtReturn* stmt)
+{
+	stmt->expr->accept(this);
+}
+
+void Resolver::visit(StmtClass* stmt)
+{
+	declare(stmt->name);
+	for (auto& m : stmt->methods)
+		function(m.get());
+}
+
+void Resolver::visit(StmtYield* stmt)
+{
+	stmt->expr->accept(this);
+}
+
+void Resolver::visit(StmtForIn* stmt)
+{
+	stmt->iterable->accept(this);
+	scopes.emplace_back();
+	declare(stmt->name);
+	stmt->body->accept(this);
+	scopes.pop_back();
+}
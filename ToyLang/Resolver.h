@@ -0,0 +1,54 @@
+#pragma once
+#include "AstVisitor.hpp"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Walks the tree before execution and binds calls to native functions
+// directly at the call site when their global has not been shadowed.
+class Resolver : public ExprVisitor, public StmtVisitor
+{
+private:
+	std::vector<Stmt*> root;
+	std::vector<std::unordered_set<std::string>> scopes;
+	std::unordered_set<std::string> reassigned;
+	// Top level functions, classes and vars, they replace natives of the same name.
+	std::unordered_set<std::string> declaredGlobals;
+	bool collecting;
+
+	void declare(Token name);
+	bool isShadowed(const std::string& name);
+	void function(StmtFunction* stmt);
+
+public:
+	Resolver(std::vector<Stmt*> root);
+	// Names assigned in bodies the parser skipped, they can not be bound statically either.
+	void assumeReassigned(const std::unordered_set<std::string>& names);
+	void resolve();
+	// Binds a lazily parsed body once it has been parsed.
+	void resolveBody(StmtFunction* stmt);
+
+	Value visit(ExprBinary* expr) override;
+	Value visit(ExprUnary* expr) override;
+	Value visit(ExprLiteral* expr) override;
+	Value visit(ExprVariableGet* expr) override;
+	Value visit(ExprVariableSet* expr) override;
+	Value visit(ExprCall* expr) override;
+	Value visit(ExprMemberGet* expr) override;
+	Value visit(ExprMemberSet* expr) override;
+	Value visit(ExprArrayGet* expr) override;
+	Value visit(ExprArraySet* expr) override;
+	Value visit(ExprSpawn* expr) override;
+
+	void visit(StmtExpr* stmt) override;
+	void visit(StmtFunction* stmt) override;
+	void visit(StmtVarDecl* stmt) override;
+	void visit(StmtBlock* stmt) override;
+	void visit(StmtIf* stmt) override;
+	void visit(StmtWhile* stmt) override;
+	void visit(StmtReturn* stmt) override;
+	void visit(StmtClass* stmt) override;
+	void visit(StmtYield* stmt) override;
+	void visit(StmtForIn* stmt) override;
+};
@@ -1,11 +1,12 @@
 #include "Scanner.h"
+#include "Simd.hpp"
 #include <cstring>
 #include <sstream>
 #include <string_view>
 #include <iomanip>
 
-Scanner::Scanner(std::string& source)
-	:source(source), startPosition(0), currentPosition(0), line(1)
+Scanner::Scanner(const char* source, size_t length, int line)
+	:source(source), length(length), startPosition(0), currentPosition(0), line(line)
 {}
 
 std::vector<Token> Scanner::scanTokens()
@@ -107,7 +108,7 @@ Token Scanner::scanToken()
 
 	default:
 		if (this->isAlpha(c))
-			return identifierLiteral(c);
+			return identifierLiteral();
 		else if (this->isDigit(c))
 			return numberLiteral();
 		return errorToken("Unexpected character");
@@ -158,6 +159,9 @@ std::string Scanner::formatString(const char* str, size_t size)
 			case '\'':
 				ss << '\'';
 				break;
+			case '"':
+				ss << '"';
+				break;
 			default:
 				break;
 			}
@@ -175,54 +179,116 @@ std::string Scanner::formatString(const char* str, size_t size)
 
 Token Scanner::stringLiteral()
 {
-	while (peek() != '"' && !this->isAtEnd())
+	const char* end = source + length;
+	const char* p = source + currentPosition;
+	int newlines = 0;
+	while (true)
 	{
-		advance();
+		p = simd::findEither(p, end, '"', '\\', newlines);
+		if (p == end || *p == '"')
+			break;
+		// skip the escaped character, which may be a newline
+		if (p + 1 < end && p[1] == '\n')
+			newlines++;
+		p = p + 2 < end ? p + 2 : end;
 	}
 
+	currentPosition = (int)(p - source);
 	if (isAtEnd())
+	{
+		line += newlines;
 		return errorToken("Unterminated string.");
+	}
 
 	advance();
 	std::string formattedString = formatString(&source[startPosition], currentPosition - startPosition - 1);
 	char* str = new char[formattedString.size() + 1];
 	formattedString.copy(str, formattedString.size());
-	return Token(TokenType::STRING_LITERAL, line, str, formattedString.size());
+	Token token(TokenType::STRING_LITERAL, line, str, formattedString.size());
+	line += newlines;
+	return token;
 }
 
-Token Scanner::identifierLiteral(char start)
+Token Scanner::identifierLiteral()
 {
-	std::stringstream lexeme;
-	lexeme << start;
 	while ((this->isAlpha(peek()) || this->isDigit(peek())))
 	{
-		lexeme << advance();
+		advance();
+	}
+
+	return makeToken(identifierType());
+}
+
+TokenType Scanner::identifierType()
+{
+	const char* lexeme = &source[startPosition];
+	int size = currentPosition - startPosition;
+
+	switch (lexeme[0])
+	{
+	case 'c':
+		return checkKeyword(1, "lass", TokenType::CLASS);
+	case 'e':
+		return checkKeyword(1, "lse", TokenType::ELSE);
+	case 'f':
+		if (size > 1)
+		{
+			switch (lexeme[1])
+			{
+			case 'a':
+				return checkKeyword(2, "lse", TokenType::FALSE);
+			case 'o':
+				return checkKeyword(2, "r", TokenType::FOR);
+			case 'u':
+				return checkKeyword(2, "nc", TokenType::FUNC);
+			}
+		}
+		break;
+	case 'i':
+		if (size > 1)
+		{
+			switch (lexeme[1])
+			{
+			case 'f':
+				return checkKeyword(2, "", TokenType::IF);
+			case 'n':
+				return checkKeyword(2, "", TokenType::IN);
+			}
+		}
+		break;
+	case 'r':
+		return checkKeyword(1, "eturn", TokenType::RETURN);
+	case 's':
+		if (size > 1)
+		{
+			switch (lexeme[1])
+			{
+			case 'e':
+				return checkKeyword(2, "lf", TokenType::SELF);
+			case 'p':
+				return checkKeyword(2, "awn", TokenType::SPAWN);
+			}
+		}
+		break;
+	case 't':
+		return checkKeyword(1, "rue", TokenType::TRUE);
+	case 'v':
+		return checkKeyword(1, "ar", TokenType::VAR);
+	case 'w':
+		return checkKeyword(1, "hile", TokenType::WHILE);
+	case 'y':
+		return checkKeyword(1, "ield", TokenType::YIELD);
 	}
 
-	if (lexeme.str() == "class")
-		return makeToken(TokenType::CLASS);
-	if (lexeme.str() == "if")
-		return makeToken(TokenType::IF);
-	if (lexeme.str() == "else")
-		return makeToken(TokenType::ELSE);
-	if (lexeme.str() == "func")
-		return makeToken(TokenType::FUNC);
-	if (lexeme.str() == "self")
-		return makeToken(TokenType::SELF);
-	if (lexeme.str() == "var")
-		return makeToken(TokenType::VAR);
-	if (lexeme.str() == "while")
-		return makeToken(TokenType::WHILE);
-	if (lexeme.str() == "for")
-		return makeToken(TokenType::FOR);
-	if (lexeme.str() == "true")
-		return makeToken(TokenType::TRUE);
-	if (lexeme.str() == "false")
-		return makeToken(TokenType::FALSE);
-	if (lexeme.str() == "return")
-		return makeToken(TokenType::RETURN);
-
-	return makeToken(TokenType::IDENTIFIER);
+	return TokenType::IDENTIFIER;
+}
+
+TokenType Scanner::checkKeyword(int offset, const char* rest, TokenType type)
+{
+	size_t restLength = strlen(rest);
+	if (currentPosition - startPosition == offset + (int)restLength && memcmp(&source[startPosition + offset], rest, restLength) == 0)
+		return type;
+	return TokenType::IDENTIFIER;
 }
 
 Token Scanner::numberLiteral()
@@ -248,41 +314,43 @@ Token Scanner::errorToken(const char* msg)
 
 void Scanner::skipWhitespace()
 {
+	const char* end = source + length;
 	while (true)
 	{
-		char c = peek();
-		switch (c)
-		{
-		case ' ':
-		case '\t':
-		case '\r':
-			advance();
-			break;
-		case '\n':
-			this->line++;
-			advance();
-			break;
+		int newlines = 0;
+		const char* p = simd::skipBlanks(source + currentPosition, end, newlines);
+		this->line += newlines;
+		this->currentPosition = (int)(p - source);
 
-		case '/':
-			if (peekNext() == '/')
-			{
-				while (peek() != '\n' && !this->isAtEnd())
-					advance();
-				skipWhitespace();
-			}
-			else if (peekNext() == '*')
+		if (peek() != '/')
+			return;
+
+		if (peekNext() == '/')
+		{
+			const char* newline = (const char*)memchr(p, '\n', end - p);
+			this->currentPosition = (int)((newline ? newline : end) - source);
+		}
+		else if (peekNext() == '*')
+		{
+			p += 2;
+			while (true)
 			{
-				while (!(peek() == '*' && peekNext() == '/') && !this->isAtEnd())
+				newlines = 0;
+				p = simd::findEither(p, end, '*', '*', newlines);
+				this->line += newlines;
+				if (p == end)
+					break;
+				if (p + 1 < end && p[1] == '/')
 				{
-					char x = advance();
-					if (x == '\n')
-						this->line++;
+					p += 2;
+					break;
 				}
-				this->currentPosition += 2;
-				skipWhitespace();
+				p++;
 			}
-			return;
-		default:
+			this->currentPosition = (int)(p - source);
+		}
+		else
+		{
 			return;
 		}
 	}
@@ -295,12 +363,14 @@ char Scanner::advance()
 
 char Scanner::peek()
 {
+	if (this->isAtEnd())
+		return '\0';
 	return source[this->currentPosition];
 }
 
 char Scanner::peekNext()
 {
-	if (this->isAtEnd())
+	if ((size_t)this->currentPosition + 1 >= length)
 		return '\0';
 	return source[this->currentPosition + 1];
 }
@@ -316,7 +386,7 @@ bool Scanner::match(char c)
 
 bool Scanner::isAtEnd()
 {
-	return this->currentPosition == source.length();
+	return (size_t)this->currentPosition >= length;
 }
 
 std::ostream& operator<<(std::ostream& os, const Token& token)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <charconv>
 #include <memory.h>
 #include <string>
 #include <vector>
@@ -61,6 +62,9 @@ enum class TokenType
 	TRUE,
 	FALSE,
 	RETURN,
+	SPAWN,
+	YIELD,
+	IN,
 
 	// Util
 	ERROR,
@@ -70,10 +74,10 @@ enum class TokenType
 class Token
 {
 public:
-	const TokenType type;
-	const int line;
+	TokenType type;
+	int line;
 	const char* start;
-	const int length;
+	int length;
 
 	Token(TokenType type, int line, const char* start, int length)
 		: type(type), line(line), start(start), length(length)
@@ -82,26 +86,19 @@ public:
 
 	double getNumber()
 	{
-		char* lexeme = new char[length + 1];
-		memcpy(lexeme, start, sizeof(char) * length);
-		lexeme[length] = 0;
-		return std::stod(lexeme);
+		double num = 0;
+		std::from_chars(start, start + length, num);
+		return num;
 	}
 
 	std::string getString()
 	{
-		char* lexeme = new char[length - 1];
-		memcpy(lexeme, start+1, sizeof(char) * length);
-		lexeme[length-2] = 0;
-		return std::string(lexeme);
+		return std::string(start + 1, length - 2);
 	}
 
 	std::string getLexeme()
 	{
-		char* lexeme = new char[length + 1];
-		memcpy(lexeme, start, sizeof(char) * length);
-		lexeme[length] = 0;
-		return std::string(lexeme);
+		return std::string(start, length);
 	}
 
 	friend std::ostream& operator<<(std::ostream& os, const Token& token);
@@ -110,21 +107,25 @@ public:
 class Scanner
 {
 public:
-	Scanner(std::string& source);
+	Scanner(const char* source, size_t length, int line = 1);
 	std::vector<Token> scanTokens();
+	// Scans the next token, returns EOF_TOKEN repeatedly once the source is exhausted.
+	Token scanToken();
 
 private:
-	std::string& source;
+	const char* source;
+	size_t length;
 	int currentPosition;
 	int startPosition;
 	int line;
 
-	Token scanToken();
 	Token makeToken(TokenType type);
 
 	std::string formatString(const char* str, size_t size);
 	Token stringLiteral();
-	Token identifierLiteral(char start);
+	Token identifierLiteral();
+	TokenType identifierType();
+	TokenType checkKeyword(int offset, const char* rest, TokenType type);
 	Token numberLiteral();
 	Token errorToken(const char* msg);
 
@@ -0,0 +1,156 @@
+#define DEBUG_TREE false
+
+#include "Script.h"
+#include "AstCache.h"
+#include "Debug.hpp"
+#include "Interpreter.h"
+#include "ParallelScanner.h"
+#include "Parser.h"
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+
+// Sources at least this large are lexed up front on all cores instead of streamed into the parser.
+constexpr size_t PARALLEL_LEX_THRESHOLD = 8 << 20;
+
+Script::Script()
+	: cached(false), finished(false)
+{}
+
+// Bodies are only brace matched by the parser and stay lazy, they are built on first call. Their syntax
+// is checked here without building anything, in runs of functions spread over the pool, so errors in
+// bodies that are never called are still reported before anything runs. Errors are printed in source order.
+static bool checkBodies(const std::vector<StmtFunction*>& funcs, std::ostream& out)
+{
+	ThreadPool& pool = ThreadPool::shared();
+	size_t chunks = std::min(pool.size() * 4, funcs.size() / 16);
+	if (chunks < 2)
+	{
+		bool clean = true;
+		for (StmtFunction* func : funcs)
+			clean = Parser::checkBody(func, out) && clean;
+		return clean;
+	}
+
+	std::vector<std::ostringstream> errors(chunks);
+	std::atomic<size_t> remaining(chunks);
+	std::atomic<bool> clean(true);
+	for (size_t c = 0; c < chunks; c++)
+	{
+		pool.submit([&, c]() {
+			size_t end = (c + 1) * funcs.size() / chunks;
+			for (size_t i = c * funcs.size() / chunks; i < end; i++)
+			{
+				if (!Parser::checkBody(funcs[i], errors[c]))
+					clean = false;
+			}
+			remaining--;
+		});
+	}
+	while (remaining > 0)
+	{
+		if (!pool.runPending())
+			std::this_thread::yield();
+	}
+
+	for (auto& chunk : errors)
+		out << chunk.str();
+	return clean;
+}
+
+std::unique_ptr<Script> Script::load(const std::string& path, std::ostream& errors)
+{
+	std::unique_ptr<Script> script = std::make_unique<Script>();
+	script->path = path;
+	Program& program = script->program;
+	program.source = SourceBuffer::load(path);
+	if (!program.source)
+	{
+		errors << "[ERROR] Unable to find file with path: " << path << std::endl;
+		return nullptr;
+	}
+
+	// The parser pulls tokens from the scanner as it goes, use scanTokens() to dump them:
+	// for (auto& token : Scanner(program.source->data(), program.source->size()).scanTokens())
+	//     std::cout << token << std::endl;
+	// A cache hit skips scanning and parsing entirely.
+	std::unordered_set<std::string> cachedAssignments;
+	script->cached = AstCache::load(AstCache::pathFor(path), program, cachedAssignments);
+
+	Scanner scanner(program.source->data(), program.source->size());
+	std::vector<Token> tokens;
+	bool parallel = !script->cached && program.source->size() >= PARALLEL_LEX_THRESHOLD;
+	if (parallel)
+		tokens = ParallelScanner(program.source->data(), program.source->size()).scanTokens(ThreadPool::shared());
+	// Function bodies are only skimmed here, see checkBodies().
+	Parser parser = parallel ? Parser(tokens, true) : Parser(scanner, true);
+	parser.errors = &errors;
+	if (!script->cached)
+		program.root = parser.parse();
+	if (parser.hadError || !checkBodies(parser.lazyFunctions, errors))
+		return nullptr;
+
+	script->roots = program.roots();
+	script->lazyFunctions = parser.lazyFunctions;
+
+#if DEBUG_TREE
+	AstDebugger astDebugger(script->roots);
+	astDebugger.debug();
+#endif
+
+	script->resolver = std::make_unique<Resolver>(script->roots);
+	script->resolver->assumeReassigned(script->cached ? cachedAssignments : parser.bodyAssignments);
+	script->resolver->resolve();
+	return script;
+}
+
+std::unique_ptr<Interpreter> Script::instantiate(Output& output)
+{
+	std::unique_ptr<Interpreter> interpreter = std::make_unique<Interpreter>(roots);
+	interpreter->resolver = resolver.get();
+	interpreter->output = &output;
+	return interpreter;
+}
+
+bool Script::run(const std::vector<std::string>& args, Output& output, SnapshotMode snapshot)
+{
+	std::unique_ptr<Interpreter> interpreter = instantiate(output);
+	interpreter->args = args;
+	return run(*interpreter, snapshot);
+}
+
+bool Script::run(Interpreter& interpreter, SnapshotMode snapshot)
+{
+	std::string snapshotPath = Snapshot::pathFor(path);
+	switch (snapshot)
+	{
+	case SnapshotMode::WRITE:
+		return interpreter.prepare(true) && Snapshot::store(snapshotPath, program, interpreter);
+	case SnapshotMode::USE:
+		// A missing or stale snapshot only costs time, main() still starts from what init() built.
+		if (Snapshot::load(snapshotPath, program, interpreter))
+			return interpreter.runMain();
+		return interpreter.prepare(true) && interpreter.runMain();
+	default:
+		return interpreter.run();
+	}
+}
+
+void Script::finish(bool clean, std::ostream& errors)
+{
+	if (finished.exchange(true))
+		return;
+
+	for (StmtFunction* func : lazyFunctions)
+	{
+		if (func->lazy && !func->bodyFailed)
+			clean = Interpreter::buildBody(func, resolver.get(), errors) && clean;
+	}
+
+	// Every body is parsed by now.
+	if (clean && !cached)
+		AstCache::store(AstCache::pathFor(path), program);
+}
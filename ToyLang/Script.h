@@ -0,0 +1,52 @@
+#pragma once
+#include "Output.h"
+#include "Resolver.h"
+#include "Source.h"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Interpreter;
+
+// How a run uses the Snapshot next to the script. Plain runs neither read one nor call init().
+enum class SnapshotMode
+{
+	NONE,
+	// Runs only the top level and init(), then saves the globals.
+	WRITE,
+	// Starts main() from a matching snapshot, or runs the top level and init() first when there is none.
+	USE
+};
+
+// A loaded and resolved program that can be run any number of times, each run with fresh globals.
+class Script
+{
+private:
+	std::vector<Stmt*> roots;
+	std::unique_ptr<Resolver> resolver;
+	// Bodies the parser skimmed, each stays lazy until its first call.
+	std::vector<StmtFunction*> lazyFunctions;
+	bool cached;
+	std::atomic<bool> finished;
+
+public:
+	std::string path;
+	Program program;
+
+	Script();
+	// Loads the tree from the AstCache or parses the source, printing errors to errors. Returns null if it can not run.
+	static std::unique_ptr<Script> load(const std::string& path, std::ostream& errors = std::cout);
+
+	// An interpreter over this script writing to output. Interpreters share only the tree, so any
+	// number of them may run at once on different threads.
+	std::unique_ptr<Interpreter> instantiate(Output& output);
+	// Returns false if the run stopped on an error, see SnapshotMode for what it does with init().
+	bool run(Interpreter& interpreter, SnapshotMode snapshot);
+	bool run(const std::vector<std::string>& args, Output& output, SnapshotMode snapshot);
+	// Builds the skimmed bodies that were never called and caches the whole tree once a run was clean.
+	// Only the first call does any work, even if several threads finish at once.
+	void finish(bool clean, std::ostream& errors = std::cout);
+};
@@ -0,0 +1,201 @@
+#include "Server.h"
+#include "Interpreter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+Server::Server(const std::string& socketPath)
+	: socketPath(socketPath)
+{}
+
+#ifdef _WIN32
+
+bool Server::serve()
+{
+	std::cout << "[ERROR] --serve needs UNIX domain sockets, which this build does not support." << std::endl;
+	return false;
+}
+
+std::shared_ptr<Script> Server::script(const std::string& path, std::ostream& errors)
+{
+	return nullptr;
+}
+
+void Server::handle(int client)
+{}
+
+#else
+
+bool Server::serve()
+{
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(addr.sun_path))
+	{
+		std::cout << "[ERROR] Socket path is too long: " << socketPath << std::endl;
+		return false;
+	}
+	memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath.c_str());
+	if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0)
+	{
+		std::cout << "[ERROR] Unable to listen on " << socketPath << ": " << strerror(errno) << std::endl;
+		if (listener >= 0)
+			close(listener);
+		return false;
+	}
+
+	// A client that hangs up early must not take the server down with it.
+	signal(SIGPIPE, SIG_IGN);
+	std::cout << "Serving on " << socketPath << std::endl;
+
+	while (true)
+	{
+		int client = accept(listener, nullptr, nullptr);
+		if (client < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		// A slow script or client only holds up its own connection.
+		std::thread([this, client]() {
+			handle(client);
+			close(client);
+		}).detach();
+	}
+
+	close(listener);
+	unlink(socketPath.c_str());
+	return true;
+}
+
+std::shared_ptr<Script> Server::script(const std::string& path, std::ostream& errors)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(scriptsLock);
+		auto it = scripts.find(path);
+		if (it != scripts.end() && it->second.modified == (long long)info.st_mtime && it->second.size == (long long)info.st_size)
+			return it->second.script;
+	}
+
+	// Loaded without the lock so other requests keep running, if two requests load the same file
+	// at once the later one is kept.
+	std::shared_ptr<Script> loaded = Script::load(path, errors);
+	std::lock_guard<std::mutex> lock(scriptsLock);
+	if (!loaded)
+	{
+		scripts.erase(path);
+		return nullptr;
+	}
+	Entry& entry = scripts[path];
+	entry.script = loaded;
+	entry.modified = (long long)info.st_mtime;
+	entry.size = (long long)info.st_size;
+	return loaded;
+}
+
+// Reads what the client sent after the request, starting with the bytes received along with it.
+class ClientInput : public std::streambuf
+{
+private:
+	int client;
+	std::string pending;
+	char chunk[4096];
+
+public:
+	ClientInput(int client, std::string pending)
+		: client(client), pending(std::move(pending))
+	{
+		setg(&this->pending[0], &this->pending[0], &this->pending[0] + this->pending.size());
+	}
+
+protected:
+	int_type underflow() override
+	{
+		ssize_t read = recv(client, chunk, sizeof(chunk), 0);
+		if (read <= 0)
+			return traits_type::eof();
+		setg(chunk, chunk, chunk + read);
+		return traits_type::to_int_type(chunk[0]);
+	}
+};
+
+void Server::handle(int client)
+{
+	std::string request;
+	char chunk[4096];
+	while (request.find("\n\n") == std::string::npos)
+	{
+		ssize_t read = recv(client, chunk, sizeof(chunk), 0);
+		if (read <= 0)
+			break;
+		request.append(chunk, read);
+	}
+
+	size_t end = request.find("\n\n");
+	std::string rest = end == std::string::npos ? std::string() : request.substr(end + 2);
+	std::vector<std::string> lines;
+	std::istringstream stream(request.substr(0, end));
+	std::string line;
+	while (std::getline(stream, line) && !line.empty())
+		lines.push_back(line);
+
+	FILE* file = fdopen(dup(client), "w");
+	if (!file)
+		return;
+	{
+		Output output(file);
+		// A request that fails in any way is reported to its client, the server keeps serving.
+		try
+		{
+			std::ostringstream errors;
+			std::shared_ptr<Script> found = lines.empty() ? nullptr : script(lines[0], errors);
+			output.write(errors.str());
+			if (!found)
+			{
+				output.write("[ERROR] Unable to run " + (lines.empty() ? std::string("an empty request") : lines[0]) + "\n");
+			}
+			else
+			{
+				ClientInput buffer(client, rest);
+				std::istream input(&buffer);
+				std::unique_ptr<Interpreter> interpreter = found->instantiate(output);
+				interpreter->input = &input;
+				interpreter->args.assign(lines.begin() + 1, lines.end());
+				bool clean = found->run(*interpreter, SnapshotMode::NONE);
+				interpreter.reset();
+				errors.str("");
+				found->finish(clean, errors);
+				output.write(errors.str());
+			}
+		}
+		catch (...)
+		{
+			output.write(Interpreter::currentError());
+		}
+	}
+	fclose(file);
+}
+
+#endif
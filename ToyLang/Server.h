@@ -0,0 +1,39 @@
+#pragma once
+#include "Script.h"
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// Keeps parsed scripts warm and runs them for clients of a UNIX domain socket, each connection on
+// a thread of its own. A request is the script path on the first line followed by one argument per
+// line and ends with an empty line or when the client shuts down its side. Whatever the client sends
+// after the empty line is what input() reads. The script output and errors, including syntax errors,
+// are streamed back and the connection is closed when the run is over. Every run gets fresh globals,
+// the parsed tree is reused until the file changes.
+class Server
+{
+private:
+	struct Entry
+	{
+		// Shared with the requests still running it when the file changes.
+		std::shared_ptr<Script> script;
+		long long modified;
+		long long size;
+	};
+
+	std::string socketPath;
+	std::unordered_map<std::string, Entry> scripts;
+	std::mutex scriptsLock;
+
+	// The loaded script at path, errors of a fresh load go to errors. Null if it can not run.
+	std::shared_ptr<Script> script(const std::string& path, std::ostream& errors);
+	void handle(int client);
+
+public:
+	Server(const std::string& socketPath);
+	// Serves requests until the process is stopped, returns false if the socket can not be opened.
+	bool serve();
+};
@@ -0,0 +1,309 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TOY_SIMD_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOY_SIMD_SSE2 1
+#endif
+
+// Bulk kernels over contiguous doubles, AVX or SSE2 when the target has them with a scalar tail.
+// Byte scanners for the Scanner, SSE2 when available with a scalar fallback.
+namespace simd
+{
+	inline unsigned countTrailingZeros(unsigned mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	inline int popCount(unsigned mask)
+	{
+#ifdef _MSC_VER
+		mask = mask - ((mask >> 1) & 0x55555555);
+		mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+		return (((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#else
+		return __builtin_popcount(mask);
+#endif
+	}
+
+	// Skips spaces, tabs, carriage returns and newlines, adding the newlines passed to newlines.
+	inline const char* skipBlanks(const char* p, const char* end, int& newlines)
+	{
+#if TOY_SIMD_SSE2
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i cr = _mm_set1_epi8('\r');
+		const __m128i nl = _mm_set1_epi8('\n');
+		while (end - p >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i*)p);
+			__m128i isNewline = _mm_cmpeq_epi8(chunk, nl);
+			__m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), isNewline));
+			unsigned mask = (unsigned)_mm_movemask_epi8(blank);
+			unsigned newlineMask = (unsigned)_mm_movemask_epi8(isNewline);
+			if (mask != 0xFFFF)
+			{
+				unsigned stop = countTrailingZeros(~mask);
+				newlines += popCount(newlineMask & ((1u << stop) - 1));
+				return p + stop;
+			}
+			newlines += popCount(newlineMask);
+			p += 16;
+		}
+#endif
+		for (; p < end; p++)
+		{
+			if (*p == '\n')
+				newlines++;
+			else if (*p != ' ' && *p != '\t' && *p != '\r')
+				break;
+		}
+		return p;
+	}
+
+	// Finds the first a or b, adding the newlines before it to newlines. Returns end if there is none.
+	inline const char* findEither(const char* p, const char* end, char a, char b, int& newlines)
+	{
+#if TOY_SIMD_SSE2
+		const __m128i va = _mm_set1_epi8(a);
+		const __m128i vb = _mm_set1_epi8(b);
+		const __m128i nl = _mm_set1_epi8('\n');
+		while (end - p >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i*)p);
+			unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+			unsigned newlineMask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl));
+			if (mask != 0)
+			{
+				unsigned stop = countTrailingZeros(mask);
+				newlines += popCount(newlineMask & ((1u << stop) - 1));
+				return p + stop;
+			}
+			newlines += popCount(newlineMask);
+			p += 16;
+		}
+#endif
+		for (; p < end; p++)
+		{
+			if (*p == a || *p == b)
+				break;
+			if (*p == '\n')
+				newlines++;
+		}
+		return p;
+	}
+
+	inline double sum(const double* a, size_t n)
+	{
+		size_t i = 0;
+		double total = 0;
+#if TOY_SIMD_AVX
+		__m256d acc0 = _mm256_setzero_pd();
+		__m256d acc1 = _mm256_setzero_pd();
+		for (; i + 8 <= n; i += 8)
+		{
+			acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+			acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+		}
+		double lanes[4];
+		_mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+		total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif TOY_SIMD_SSE2
+		__m128d acc0 = _mm_setzero_pd();
+		__m128d acc1 = _mm_setzero_pd();
+		for (; i + 4 <= n; i += 4)
+		{
+			acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+			acc1 = _mm_add_pd(acc1, _mm_loadu_pd(a + i + 2));
+		}
+		double lanes[2];
+		_mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+		total = lanes[0] + lanes[1];
+#endif
+		for (; i < n; i++)
+			total += a[i];
+		return total;
+	}
+
+	inline double dot(const double* a, const double* b, size_t n)
+	{
+		size_t i = 0;
+		double total = 0;
+#if TOY_SIMD_AVX
+		__m256d acc0 = _mm256_setzero_pd();
+		__m256d acc1 = _mm256_setzero_pd();
+		for (; i + 8 <= n; i += 8)
+		{
+			acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+			acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+		}
+		double lanes[4];
+		_mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+		total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif TOY_SIMD_SSE2
+		__m128d acc0 = _mm_setzero_pd();
+		__m128d acc1 = _mm_setzero_pd();
+		for (; i + 4 <= n; i += 4)
+		{
+			acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+			acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+		}
+		double lanes[2];
+		_mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+		total = lanes[0] + lanes[1];
+#endif
+		for (; i < n; i++)
+			total += a[i] * b[i];
+		return total;
+	}
+
+	inline void scale(double* a, double k, size_t n)
+	{
+		size_t i = 0;
+#if TOY_SIMD_AVX
+		__m256d vk = _mm256_set1_pd(k);
+		for (; i + 4 <= n; i += 4)
+			_mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), vk));
+#elif TOY_SIMD_SSE2
+		__m128d vk = _mm_set1_pd(k);
+		for (; i + 2 <= n; i += 2)
+			_mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), vk));
+#endif
+		for (; i < n; i++)
+			a[i] *= k;
+	}
+
+	// a[i] += b[i]
+	inline void add(double* a, const double* b, size_t n)
+	{
+		size_t i = 0;
+#if TOY_SIMD_AVX
+		for (; i + 4 <= n; i += 4)
+			_mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+#elif TOY_SIMD_SSE2
+		for (; i + 2 <= n; i += 2)
+			_mm_storeu_pd(a + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+#endif
+		for (; i < n; i++)
+			a[i] += b[i];
+	}
+
+	// n must be greater than zero. Any NaN in a makes the result NaN, the vector loop tracks NaN lanes
+	// separately because min_pd alone keeps or drops one depending on its operand order.
+	inline double min(const double* a, size_t n)
+	{
+		size_t i = 0;
+		double res = a[0];
+#if TOY_SIMD_AVX
+		if (n >= 4)
+		{
+			__m256d acc = _mm256_loadu_pd(a);
+			__m256d nan = _mm256_cmp_pd(acc, acc, _CMP_UNORD_Q);
+			for (i = 4; i + 4 <= n; i += 4)
+			{
+				__m256d v = _mm256_loadu_pd(a + i);
+				nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+				acc = _mm256_min_pd(acc, v);
+			}
+			if (_mm256_movemask_pd(nan))
+				return std::numeric_limits<double>::quiet_NaN();
+			double lanes[4];
+			_mm256_storeu_pd(lanes, acc);
+			for (double l : lanes)
+				res = l < res ? l : res;
+		}
+#elif TOY_SIMD_SSE2
+		if (n >= 2)
+		{
+			__m128d acc = _mm_loadu_pd(a);
+			__m128d nan = _mm_cmpunord_pd(acc, acc);
+			for (i = 2; i + 2 <= n; i += 2)
+			{
+				__m128d v = _mm_loadu_pd(a + i);
+				nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+				acc = _mm_min_pd(acc, v);
+			}
+			if (_mm_movemask_pd(nan))
+				return std::numeric_limits<double>::quiet_NaN();
+			double lanes[2];
+			_mm_storeu_pd(lanes, acc);
+			for (double l : lanes)
+				res = l < res ? l : res;
+		}
+#endif
+		for (; i < n; i++)
+		{
+			if (std::isnan(a[i]))
+				return std::numeric_limits<double>::quiet_NaN();
+			res = a[i] < res ? a[i] : res;
+		}
+		return res;
+	}
+
+	// n must be greater than zero. Any NaN in a makes the result NaN, like min().
+	inline double max(const double* a, size_t n)
+	{
+		size_t i = 0;
+		double res = a[0];
+#if TOY_SIMD_AVX
+		if (n >= 4)
+		{
+			__m256d acc = _mm256_loadu_pd(a);
+			__m256d nan = _mm256_cmp_pd(acc, acc, _CMP_UNORD_Q);
+			for (i = 4; i + 4 <= n; i += 4)
+			{
+				__m256d v = _mm256_loadu_pd(a + i);
+				nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+				acc = _mm256_max_pd(acc, v);
+			}
+			if (_mm256_movemask_pd(nan))
+				return std::numeric_limits<double>::quiet_NaN();
+			double lanes[4];
+			_mm256_storeu_pd(lanes, acc);
+			for (double l : lanes)
+				res = l > res ? l : res;
+		}
+#elif TOY_SIMD_SSE2
+		if (n >= 2)
+		{
+			__m128d acc = _mm_loadu_pd(a);
+			__m128d nan = _mm_cmpunord_pd(acc, acc);
+			for (i = 2; i + 2 <= n; i += 2)
+			{
+				__m128d v = _mm_loadu_pd(a + i);
+				nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+				acc = _mm_max_pd(acc, v);
+			}
+			if (_mm_movemask_pd(nan))
+				return std::numeric_limits<double>::quiet_NaN();
+			double lanes[2];
+			_mm_storeu_pd(lanes, acc);
+			for (double l : lanes)
+				res = l > res ? l : res;
+		}
+#endif
+		for (; i < n; i++)
+		{
+			if (std::isnan(a[i]))
+				return std::numeric_limits<double>::quiet_NaN();
+			res = a[i] > res ? a[i] : res;
+		}
+		return res;
+	}
+}
@@ -0,0 +1,589 @@
+#include "Snapshot.h"
+#include "AstCache.h"
+#include "Enviroment.hpp"
+#include "ToyClass.h"
+#include "NativeArray.hpp"
+#include "NativeFloat64Array.hpp"
+#include "NativeMap.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace
+{
+	const char MAGIC[4] = { 'T', 'O', 'Y', 'S' };
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+		uint32_t functionCount;
+		uint32_t classCount;
+		uint32_t objectCount;
+		uint32_t globalCount;
+		uint64_t shellSize;
+		uint64_t contentSize;
+		uint64_t globalSize;
+	};
+
+	enum : uint8_t
+	{
+		VAL_NIL,
+		VAL_FALSE,
+		VAL_TRUE,
+		VAL_NUMBER,
+		VAL_STRING,
+		VAL_OBJECT
+	};
+
+	enum : uint8_t
+	{
+		OBJ_INSTANCE,
+		OBJ_ARRAY,
+		OBJ_FLOAT64_ARRAY,
+		OBJ_MAP,
+		OBJ_SET,
+		OBJ_FUNCTION,
+		OBJ_CLASS,
+		OBJ_NATIVE
+	};
+
+	struct CorruptSnapshot {};
+
+	// Functions and classes are numbered in declaration order, methods following their class.
+	struct ProgramIndex
+	{
+		std::vector<StmtFunction*> functions;
+		std::vector<StmtClass*> classes;
+		std::unordered_map<StmtFunction*, uint32_t> functionIds;
+		std::unordered_map<std::string, uint32_t> classIds;
+
+		ProgramIndex(const Program& program)
+		{
+			for (auto& stmt : program.root)
+			{
+				if (StmtFunction* func = dynamic_cast<StmtFunction*>(stmt.get()))
+				{
+					addFunction(func);
+				}
+				else if (StmtClass* klass = dynamic_cast<StmtClass*>(stmt.get()))
+				{
+					classIds[klass->name.getLexeme()] = (uint32_t)classes.size();
+					classes.push_back(klass);
+					for (auto& m : klass->methods)
+						addFunction(m.get());
+				}
+			}
+		}
+
+		void addFunction(StmtFunction* func)
+		{
+			functionIds[func] = (uint32_t)functions.size();
+			functions.push_back(func);
+		}
+	};
+
+	class Writer
+	{
+	private:
+		const ProgramIndex& index;
+		std::unordered_map<Callable*, std::string> nativeNames;
+		std::unordered_map<const void*, uint32_t> ids;
+		std::vector<Value> objects;
+
+		template<typename T>
+		static void put(std::string& out, T val)
+		{
+			out.append((const char*)&val, sizeof(T));
+		}
+
+		static void putString(std::string& out, const std::string& str)
+		{
+			put<uint32_t>(out, (uint32_t)str.size());
+			out.append(str);
+		}
+
+		static std::string describe(ToyInstance* instance)
+		{
+			return instance->klass ? instance->klass->name() : "native";
+		}
+
+		// Returns the id of the object, appending its shell the first time it is seen.
+		uint32_t object(const Value& val)
+		{
+			const void* ptr = val.tag == TypeTag::CALLABLE
+				? (const void*)std::get<std::shared_ptr<Callable>>(val.data).get()
+				: (const void*)std::get<std::shared_ptr<ToyInstance>>(val.data).get();
+			auto it = ids.find(ptr);
+			if (it != ids.end())
+				return it->second;
+
+			uint32_t id = (uint32_t)objects.size();
+			ids[ptr] = id;
+			objects.push_back(val);
+
+			if (val.tag == TypeTag::CALLABLE)
+			{
+				Callable* callable = std::get<std::shared_ptr<Callable>>(val.data).get();
+				auto native = nativeNames.find(callable);
+				if (native != nativeNames.end())
+				{
+					put<uint8_t>(shells, OBJ_NATIVE);
+					putString(shells, native->second);
+				}
+				else if (typeid(*callable) == typeid(ToyFunction))
+				{
+					auto func = index.functionIds.find(((ToyFunction*)callable)->func);
+					if (func == index.functionIds.end())
+						throw "[ERROR] Snapshot can not store the function '" + callable->name() + "'.\n";
+					put<uint8_t>(shells, OBJ_FUNCTION);
+					put<uint32_t>(shells, func->second);
+				}
+				else if (typeid(*callable) == typeid(ToyClass))
+				{
+					put<uint8_t>(shells, OBJ_CLASS);
+					put<uint32_t>(shells, classId(callable->name()));
+				}
+				else
+				{
+					throw "[ERROR] Snapshot can not store the native '" + callable->name() + "'.\n";
+				}
+				return id;
+			}
+
+			ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(val.data).get();
+			if (typeid(*instance) == typeid(ToyInstance))
+			{
+				put<uint8_t>(shells, OBJ_INSTANCE);
+				put<uint32_t>(shells, classId(instance->klass->name()));
+			}
+			else if (typeid(*instance) == typeid(NativeArray::ArrayInstance))
+				put<uint8_t>(shells, OBJ_ARRAY);
+			else if (typeid(*instance) == typeid(NativeFloat64Array::Float64ArrayInstance))
+				put<uint8_t>(shells, OBJ_FLOAT64_ARRAY);
+			else if (typeid(*instance) == typeid(NativeMap::MapInstance))
+				put<uint8_t>(shells, OBJ_MAP);
+			else if (typeid(*instance) == typeid(NativeSet::SetInstance))
+				put<uint8_t>(shells, OBJ_SET);
+			else
+				throw "[ERROR] Snapshot can not store a " + describe(instance) + " instance.\n";
+			return id;
+		}
+
+		uint32_t classId(const std::string& name)
+		{
+			auto it = index.classIds.find(name);
+			if (it == index.classIds.end())
+				throw "[ERROR] Snapshot can not store the class '" + name + "'.\n";
+			return it->second;
+		}
+
+		void content(const Value& val)
+		{
+			if (val.tag == TypeTag::CALLABLE)
+			{
+				Callable* callable = std::get<std::shared_ptr<Callable>>(val.data).get();
+				if (typeid(*callable) == typeid(ToyFunction))
+					value(contents, ((ToyFunction*)callable)->self);
+				return;
+			}
+
+			ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(val.data).get();
+			put<uint32_t>(contents, (uint32_t)instance->fields.size());
+			for (auto& field : instance->fields)
+			{
+				putString(contents, field.first);
+				value(contents, field.second);
+			}
+
+			if (auto arr = dynamic_cast<NativeArray::ArrayInstance*>(instance))
+			{
+				put<uint64_t>(contents, arr->vec.size());
+				for (auto& v : arr->vec)
+					value(contents, v);
+			}
+			else if (auto arr = dynamic_cast<NativeFloat64Array::Float64ArrayInstance*>(instance))
+			{
+				put<uint64_t>(contents, arr->vec.size());
+				contents.append((const char*)arr->vec.data(), arr->vec.size() * sizeof(double));
+			}
+			else if (auto map = dynamic_cast<NativeMap::MapInstance*>(instance))
+			{
+				put<uint64_t>(contents, map->table.size());
+				map->table.forEach([this](const Value& key, Value& val) {
+					value(contents, key);
+					value(contents, val);
+				});
+			}
+			else if (auto set = dynamic_cast<NativeSet::SetInstance*>(instance))
+			{
+				put<uint64_t>(contents, set->table.size());
+				set->table.forEach([this](const Value& key, bool&) {
+					value(contents, key);
+				});
+			}
+		}
+
+	public:
+		std::string shells;
+		std::string contents;
+		std::string globals;
+		uint32_t globalCount = 0;
+
+		Writer(const ProgramIndex& index, Interpreter& interpreter)
+			: index(index)
+		{
+			for (auto& native : interpreter.natives)
+			{
+				if (native.second.tag == TypeTag::CALLABLE)
+					nativeNames[std::get<std::shared_ptr<Callable>>(native.second.data).get()] = native.first;
+			}
+		}
+
+		void value(std::string& out, const Value& val)
+		{
+			switch (val.tag)
+			{
+			case TypeTag::BOOL:
+				put<uint8_t>(out, std::get<bool>(val.data) ? VAL_TRUE : VAL_FALSE);
+				break;
+			case TypeTag::NUMBER:
+				put<uint8_t>(out, VAL_NUMBER);
+				put<double>(out, std::get<double>(val.data));
+				break;
+			case TypeTag::STRING:
+				put<uint8_t>(out, VAL_STRING);
+				putString(out, std::get<std::string>(val.data));
+				break;
+			case TypeTag::CALLABLE:
+			case TypeTag::INSTANCE:
+			{
+				uint32_t id = object(val);
+				put<uint8_t>(out, VAL_OBJECT);
+				put<uint32_t>(out, id);
+				break;
+			}
+			default:
+				put<uint8_t>(out, VAL_NIL);
+				break;
+			}
+		}
+
+		void global(const std::string& name, const Value& val)
+		{
+			putString(globals, name);
+			value(globals, val);
+			globalCount++;
+		}
+
+		// Contents can reach new objects, so this runs until no object is left without one.
+		void contentsOfAll()
+		{
+			for (size_t i = 0; i < objects.size(); i++)
+				content(objects[i]);
+		}
+
+		uint32_t objectCount() const
+		{
+			return (uint32_t)objects.size();
+		}
+	};
+
+	class Reader
+	{
+	private:
+		const char* p;
+		const char* end;
+
+	public:
+		Reader(const char* data, size_t size)
+			: p(data), end(data + size)
+		{}
+
+		template<typename T>
+		T get()
+		{
+			if ((size_t)(end - p) < sizeof(T))
+				throw CorruptSnapshot();
+			T val;
+			memcpy(&val, p, sizeof(T));
+			p += sizeof(T);
+			return val;
+		}
+
+		const char* bytes(size_t size)
+		{
+			if ((size_t)(end - p) < size)
+				throw CorruptSnapshot();
+			const char* res = p;
+			p += size;
+			return res;
+		}
+
+		std::string string()
+		{
+			uint32_t length = get<uint32_t>();
+			return std::string(bytes(length), length);
+		}
+
+		Value value(const std::vector<Value>& objects)
+		{
+			switch (get<uint8_t>())
+			{
+			case VAL_NIL:
+				return Value();
+			case VAL_FALSE:
+				return Value(false);
+			case VAL_TRUE:
+				return Value(true);
+			case VAL_NUMBER:
+				return Value(get<double>());
+			case VAL_STRING:
+				return Value(string());
+			case VAL_OBJECT:
+			{
+				uint32_t id = get<uint32_t>();
+				if (id >= objects.size())
+					throw CorruptSnapshot();
+				return objects[id];
+			}
+			default:
+				throw CorruptSnapshot();
+			}
+		}
+
+		bool atEnd() const
+		{
+			return p == end;
+		}
+	};
+
+	template<typename T>
+	T* nativeClass(Interpreter& interpreter, const std::string& name)
+	{
+		return dynamic_cast<T*>(std::get<std::shared_ptr<Callable>>(interpreter.natives[name].data).get());
+	}
+}
+
+std::string Snapshot::pathFor(const std::string& scriptPath)
+{
+	return scriptPath + "s";
+}
+
+bool Snapshot::store(const std::string& snapshotPath, const Program& program, Interpreter& interpreter)
+{
+	ProgramIndex index(program);
+	Writer writer(index, interpreter);
+	try
+	{
+		for (auto& global : interpreter.globals->vars)
+		{
+			// Natives still bound to their own name are registered again when the snapshot is loaded.
+			auto native = interpreter.natives.find(global.first);
+			if (native != interpreter.natives.end() && native->second.data == global.second.data)
+				continue;
+			writer.global(global.first, global.second);
+		}
+		writer.contentsOfAll();
+	}
+	catch (std::string err)
+	{
+		std::cout << err;
+		return false;
+	}
+
+	Header header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sourceHash = AstCache::hashSource(program.source->data(), program.source->size());
+	header.sourceSize = program.source->size();
+	header.functionCount = (uint32_t)index.functions.size();
+	header.classCount = (uint32_t)index.classes.size();
+	header.objectCount = writer.objectCount();
+	header.globalCount = writer.globalCount;
+	header.shellSize = writer.shells.size();
+	header.contentSize = writer.contents.size();
+	header.globalSize = writer.globals.size();
+
+	// Runs started with --use-snapshot may have the old one mapped, it is replaced by rename.
+	std::string tempPath;
+	FILE* file = AstCache::createTemp(snapshotPath, tempPath);
+	if (!file)
+	{
+		std::cout << "[ERROR] Unable to write the snapshot " << snapshotPath << std::endl;
+		return false;
+	}
+	bool written = fwrite(&header, sizeof(Header), 1, file) == 1
+		&& fwrite(writer.shells.data(), 1, writer.shells.size(), file) == writer.shells.size()
+		&& fwrite(writer.contents.data(), 1, writer.contents.size(), file) == writer.contents.size()
+		&& fwrite(writer.globals.data(), 1, writer.globals.size(), file) == writer.globals.size();
+	written = fclose(file) == 0 && written;
+	if (!written)
+		remove(tempPath.c_str());
+	if (!written || !AstCache::replaceWith(tempPath, snapshotPath))
+	{
+		std::cout << "[ERROR] Unable to write the snapshot " << snapshotPath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Snapshot::load(const std::string& snapshotPath, const Program& program, Interpreter& interpreter)
+{
+	std::shared_ptr<SourceBuffer> image = SourceBuffer::load(snapshotPath, true);
+	if (!image || image->size() < sizeof(Header))
+		return false;
+
+	ProgramIndex index(program);
+	Header header;
+	memcpy(&header, image->data(), sizeof(Header));
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.sourceSize != program.source->size()
+		|| header.functionCount != index.functions.size() || header.classCount != index.classes.size()
+		|| sizeof(Header) + header.shellSize + header.contentSize + header.globalSize != image->size()
+		|| header.sourceHash != AstCache::hashSource(program.source->data(), program.source->size()))
+		return false;
+
+	interpreter.defineNatives();
+	NativeArray* arrayClass = nativeClass<NativeArray>(interpreter, "Array");
+	NativeFloat64Array* float64ArrayClass = nativeClass<NativeFloat64Array>(interpreter, "Float64Array");
+	NativeMap* mapClass = nativeClass<NativeMap>(interpreter, "Map");
+	NativeSet* setClass = nativeClass<NativeSet>(interpreter, "Set");
+
+	const char* data = image->data() + sizeof(Header);
+	Reader shells(data, (size_t)header.shellSize);
+	Reader contents(data + header.shellSize, (size_t)header.contentSize);
+	Reader globals(data + header.shellSize + header.contentSize, (size_t)header.globalSize);
+
+	std::vector<std::shared_ptr<ToyClass>> classes(index.classes.size());
+	auto classAt = [&](uint32_t id) {
+		if (id >= classes.size())
+			throw CorruptSnapshot();
+		if (!classes[id])
+			classes[id] = std::make_shared<ToyClass>(index.classes[id]->name.getLexeme(), index.classes[id]->methods);
+		return classes[id];
+	};
+
+	try
+	{
+		// Every object is created first so contents can refer to any of them, cycles included.
+		std::vector<Value> objects;
+		objects.reserve(header.objectCount);
+		for (uint32_t i = 0; i < header.objectCount; i++)
+		{
+			switch (shells.get<uint8_t>())
+			{
+			case OBJ_INSTANCE:
+				objects.push_back(Value(std::make_shared<ToyInstance>(classAt(shells.get<uint32_t>()).get())));
+				break;
+			case OBJ_ARRAY:
+				objects.push_back(Value(std::shared_ptr<ToyInstance>(std::make_shared<NativeArray::ArrayInstance>(arrayClass))));
+				break;
+			case OBJ_FLOAT64_ARRAY:
+				objects.push_back(Value(std::shared_ptr<ToyInstance>(std::make_shared<NativeFloat64Array::Float64ArrayInstance>(float64ArrayClass))));
+				break;
+			case OBJ_MAP:
+				objects.push_back(Value(std::shared_ptr<ToyInstance>(std::make_shared<NativeMap::MapInstance>(mapClass))));
+				break;
+			case OBJ_SET:
+				objects.push_back(Value(std::shared_ptr<ToyInstance>(std::make_shared<NativeSet::SetInstance>(setClass))));
+				break;
+			case OBJ_FUNCTION:
+			{
+				uint32_t id = shells.get<uint32_t>();
+				if (id >= index.functions.size())
+					throw CorruptSnapshot();
+				objects.push_back(Value(std::make_shared<ToyFunction>(index.functions[id])));
+				break;
+			}
+			case OBJ_CLASS:
+				objects.push_back(Value(std::shared_ptr<Callable>(classAt(shells.get<uint32_t>()))));
+				break;
+			case OBJ_NATIVE:
+			{
+				auto native = interpreter.natives.find(shells.string());
+				if (native == interpreter.natives.end() || native->second.tag != TypeTag::CALLABLE)
+					throw CorruptSnapshot();
+				objects.push_back(native->second);
+				break;
+			}
+			default:
+				throw CorruptSnapshot();
+			}
+		}
+
+		for (auto& obj : objects)
+		{
+			if (obj.tag == TypeTag::CALLABLE)
+			{
+				Callable* callable = std::get<std::shared_ptr<Callable>>(obj.data).get();
+				if (typeid(*callable) == typeid(ToyFunction))
+					((ToyFunction*)callable)->self = contents.value(objects);
+				continue;
+			}
+
+			ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(obj.data).get();
+			uint32_t fieldCount = contents.get<uint32_t>();
+			for (uint32_t i = 0; i < fieldCount; i++)
+			{
+				std::string name = contents.string();
+				instance->fields[name] = contents.value(objects);
+			}
+
+			if (auto arr = dynamic_cast<NativeArray::ArrayInstance*>(instance))
+			{
+				uint64_t size = contents.get<uint64_t>();
+				arr->vec.reserve((size_t)std::min<uint64_t>(size, header.contentSize));
+				for (uint64_t i = 0; i < size; i++)
+					arr->vec.push_back(contents.value(objects));
+			}
+			else if (auto arr = dynamic_cast<NativeFloat64Array::Float64ArrayInstance*>(instance))
+			{
+				uint64_t size = contents.get<uint64_t>();
+				if (size > header.contentSize / sizeof(double))
+					throw CorruptSnapshot();
+				arr->vec.resize((size_t)size);
+				memcpy(arr->vec.data(), contents.bytes((size_t)size * sizeof(double)), (size_t)size * sizeof(double));
+			}
+			else if (auto map = dynamic_cast<NativeMap::MapInstance*>(instance))
+			{
+				uint64_t size = contents.get<uint64_t>();
+				for (uint64_t i = 0; i < size; i++)
+				{
+					Value key = contents.value(objects);
+					map->table.insert(key) = contents.value(objects);
+				}
+			}
+			else if (auto set = dynamic_cast<NativeSet::SetInstance*>(instance))
+			{
+				uint64_t size = contents.get<uint64_t>();
+				for (uint64_t i = 0; i < size; i++)
+					set->table.insert(contents.value(objects)) = true;
+			}
+		}
+
+		for (uint32_t i = 0; i < header.globalCount; i++)
+		{
+			std::string name = globals.string();
+			interpreter.globals->vars[name] = globals.value(objects);
+		}
+
+		if (!shells.atEnd() || !contents.atEnd() || !globals.atEnd())
+			throw CorruptSnapshot();
+	}
+	catch (CorruptSnapshot)
+	{
+		interpreter.defineNatives();
+		return false;
+	}
+	catch (std::string err)
+	{
+		interpreter.defineNatives();
+		return false;
+	}
+	return true;
+}
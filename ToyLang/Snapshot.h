@@ -0,0 +1,24 @@
+#pragma once
+#include "Interpreter.h"
+#include "Source.h"
+
+#include <cstdint>
+#include <string>
+
+// Image of the globals after the top level declarations and init() ran, kept next to the
+// script as "<script>s". It records numbers, strings, arrays, typed arrays, maps, sets,
+// instances of script classes and references to functions and classes, which are stored
+// as indices into the program tree, so it is only used while the source hash matches. See SnapshotMode.
+class Snapshot
+{
+public:
+	// Bump whenever the encoding changes.
+	static constexpr uint32_t VERSION = 1;
+
+	static std::string pathFor(const std::string& scriptPath);
+
+	// Writes the globals of a prepared interpreter, prints the reason and returns false if one can not be stored.
+	static bool store(const std::string& snapshotPath, const Program& program, Interpreter& interpreter);
+	// Gives the interpreter fresh natives and the stored globals, ready for runMain(). Returns false on a miss.
+	static bool load(const std::string& snapshotPath, const Program& program, Interpreter& interpreter);
+};
@@ -0,0 +1,25 @@
+#include "Source.h"
+
+SourceBuffer::SourceBuffer()
+	: ptr(""), length(0)
+{}
+
+std::shared_ptr<SourceBuffer> SourceBuffer::load(const std::string& path, bool mappable)
+{
+	std::shared_ptr<SourceBuffer> source = std::make_shared<SourceBuffer>();
+	if (mappable && source->mapped.open(path))
+	{
+		if (source->mapped.size() > 0)
+		{
+			source->ptr = source->mapped.data();
+			source->length = source->mapped.size();
+		}
+		return source;
+	}
+
+	if (!MappedFile::readAll(path, source->fallback))
+		return nullptr;
+	source->ptr = source->fallback.data();
+	source->length = source->fallback.size();
+	return source;
+}
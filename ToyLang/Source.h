@@ -0,0 +1,45 @@
+#pragma once
+#include "AST.h"
+#include "MappedFile.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Contents of a script, cache or snapshot file. Scripts are read into memory: lazy bodies are parsed
+// from the text long after loading and editors may rewrite the file in place meanwhile, which would
+// change a mapping under the parser or fault it with SIGBUS on truncation. AST caches and snapshots
+// are mapped, they are only ever replaced by rename so a mapping keeps the old file.
+class SourceBuffer
+{
+private:
+	MappedFile mapped;
+	std::string fallback;
+	const char* ptr;
+	size_t length;
+
+public:
+	SourceBuffer();
+	static std::shared_ptr<SourceBuffer> load(const std::string& path, bool mappable = false);
+
+	const char* data() const { return ptr; }
+	size_t size() const { return length; }
+};
+
+// Tokens and the tree point into the source text, so a program keeps its source alive for as long as the tree.
+struct Program
+{
+	std::shared_ptr<SourceBuffer> source;
+	// Set when the tree was loaded from an AstCache, its tokens point into this mapping instead.
+	std::shared_ptr<SourceBuffer> cache;
+	std::vector<std::unique_ptr<Stmt>> root;
+
+	std::vector<Stmt*> roots() const
+	{
+		std::vector<Stmt*> root_ref;
+		root_ref.reserve(root.size());
+		for (auto& u_ptr : root)
+			root_ref.push_back(u_ptr.get());
+		return root_ref;
+	}
+};
@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+
+// The pool and queue the current thread works for, null outside of worker threads.
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local size_t currentQueue = 0;
+
+ThreadPool::ThreadPool(size_t threads)
+	: queued(0), unfinished(0), stopping(false)
+{
+	if (threads == 0)
+		threads = 1;
+	for (size_t i = 0; i <= threads; i++)
+		queues.push_back(std::make_unique<Queue>());
+	for (size_t i = 0; i < threads; i++)
+		workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	available.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency());
+	return pool;
+}
+
+size_t ThreadPool::home()
+{
+	return currentPool == this ? currentQueue : workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	// Counted before it is visible, so a thief never takes queued below zero.
+	unfinished++;
+	queued++;
+	Queue& queue = *queues[home()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+	{
+		// Taken so a worker between checking queued and sleeping can not miss the wake up.
+		std::lock_guard<std::mutex> lock(mutex);
+	}
+	available.notify_one();
+}
+
+bool ThreadPool::take(size_t index, std::function<void()>& task)
+{
+	if (queued == 0)
+		return false;
+
+	// Newest first from our own queue, then oldest first from the shared one and the other workers.
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		size_t victim = (index + i) % queues.size();
+		Queue& queue = *queues[victim];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+			continue;
+		if (i == 0 && index < workers.size())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::finish()
+{
+	if (--unfinished == 0)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		idle.notify_all();
+	}
+}
+
+bool ThreadPool::runPending()
+{
+	std::function<void()> task;
+	if (!take(home(), task))
+		return false;
+	task();
+	finish();
+	return true;
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return unfinished == 0; });
+}
+
+void ThreadPool::work(size_t index)
+{
+	currentPool = this;
+	currentQueue = index;
+	while (true)
+	{
+		std::function<void()> task;
+		if (take(index, task))
+		{
+			task();
+			finish();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		available.wait(lock, [this] { return stopping || queued > 0; });
+		if (stopping && queued == 0)
+			return;
+	}
+}
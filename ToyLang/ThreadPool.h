@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with a deque each. A worker pushes and pops its own tasks at the back,
+// so nested tasks run depth first, and idle workers steal the oldest tasks from the front of the
+// others. Threads outside the pool submit through a shared queue.
+class ThreadPool
+{
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::thread> workers;
+	// One queue per worker, the shared queue last.
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::mutex mutex;
+	std::condition_variable available;
+	std::condition_variable idle;
+	// Tasks waiting in the queues, and tasks submitted but not finished.
+	std::atomic<size_t> queued;
+	std::atomic<size_t> unfinished;
+	bool stopping;
+
+	void work(size_t index);
+	size_t home();
+	bool take(size_t index, std::function<void()>& task);
+	void finish();
+
+public:
+	explicit ThreadPool(size_t threads);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// One worker per hardware thread, started on first use.
+	static ThreadPool& shared();
+
+	void submit(std::function<void()> task);
+	// Runs one waiting task on the calling thread, returns false if there was none. Lets a thread
+	// that waits for a task help with the work instead of blocking a worker.
+	bool runPending();
+	// Blocks until every submitted task has finished.
+	void wait();
+	size_t size() const { return workers.size(); }
+};
@@ -1,7 +1,7 @@
 #include "ToyClass.h"
 
 ToyInstance::ToyInstance(ToyClass* klass)
-	: klass(klass)
+	: klass(klass), creator(Interpreter::current ? Interpreter::current->contextId : 0), frozenBy(0), frozenEpoch(0)
 { }
 
 Value ToyInstance::get(Value instance, std::string name)
@@ -35,6 +35,22 @@ Value ToyInstance::bindTo(Value instance, Callable* callable)
 	return ((ToyFunction*)callable)->bind(instance);
 }
 
+bool ToyInstance::getIndex(const Value&, Value&)
+{
+	return false;
+}
+
+bool ToyInstance::setIndex(const Value&, const Value&)
+{
+	return false;
+}
+
+void ToyInstance::forEachValue(const std::function<void(const Value&)>& fn)
+{
+	for (auto& field : fields)
+		fn(field.second);
+}
+
 ToyClass::ToyClass(std::string m_name, const std::vector<std::unique_ptr<StmtFunction>>& stmt_methods)
 	: m_name(m_name), init(nullptr)
 {
@@ -3,6 +3,8 @@
 #include "Callable.hpp"
 #include "Value.h"
 
+#include <functional>
+
 class ToyClass;
 
 class ToyInstance
@@ -10,13 +12,34 @@ class ToyInstance
 public:
 	ToyClass* klass;
 	std::unordered_map<std::string, Value> fields;
+	// Context id of the interpreter that created the object, 0 if none was running, and of the one
+	// whose tasks are reading it during its task epoch frozenEpoch. See Interpreter::checkWrite().
+	uint64_t creator;
+	uint64_t frozenBy;
+	uint64_t frozenEpoch;
 	ToyInstance(ToyClass* klass);
+	virtual ~ToyInstance() = default;
 
 	Value get(Value instance, std::string name);
 	void set(std::string name, Value val);
 	virtual Value bindTo(Value instance, Callable* callable);
+
+	// Native containers override these to serve [] in place, returning false falls back to __iget__/__iset__.
+	virtual bool getIndex(const Value& index, Value& out);
+	virtual bool setIndex(const Value& index, const Value& val);
+	// Calls fn with every value the object holds, containers override it to visit their storage.
+	virtual void forEachValue(const std::function<void(const Value&)>& fn);
 };
 
+// self of a native method that changes it, after checking that interpreter may.
+template<typename T>
+T* writableSelf(Interpreter* interpreter, const Value& self)
+{
+	ToyInstance* instance = std::get<std::shared_ptr<ToyInstance>>(self.data).get();
+	interpreter->checkWrite(instance);
+	return (T*)instance;
+}
+
 class ToyClass : public Callable
 {
 public:
@@ -0,0 +1,34 @@
+#include "ToyVM.h"
+#include "Interpreter.h"
+#include "Script.h"
+
+std::shared_ptr<Script> ToyVM::compile(const std::string& path)
+{
+	return std::shared_ptr<Script>(Script::load(path));
+}
+
+ToyVM::ToyVM(std::shared_ptr<Script> script, Output::Sink sink)
+	: script(script), output(sink ? std::make_unique<Output>(sink) : std::make_unique<Output>(stdout))
+{
+	interpreter = this->script->instantiate(*output);
+}
+
+// Out of line so Interpreter can stay incomplete in the header.
+ToyVM::~ToyVM()
+{}
+
+bool ToyVM::run(const std::vector<std::string>& args)
+{
+	interpreter->args = args;
+	return interpreter->prepare() && interpreter->runMain();
+}
+
+bool ToyVM::call(const std::string& name, const std::vector<Value>& args, Value& result)
+{
+	return interpreter->call(name, args, result);
+}
+
+const std::string& ToyVM::error() const
+{
+	return interpreter->error;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Output.h"
+#include "Value.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Interpreter;
+class Script;
+
+// Embedding API. A ToyVM owns its globals, output and error state, any number of them may run the
+// same compiled script at once on different threads. A single ToyVM is used by one thread at a time.
+class ToyVM
+{
+private:
+	std::shared_ptr<Script> script;
+	std::unique_ptr<Output> output;
+	std::unique_ptr<Interpreter> interpreter;
+
+public:
+	// Loads and resolves a script, printing syntax errors. Returns null if it can not run.
+	static std::shared_ptr<Script> compile(const std::string& path);
+
+	// Output goes to sink, or through a buffer of its own to stdout when sink is empty.
+	ToyVM(std::shared_ptr<Script> script, Output::Sink sink = nullptr);
+	~ToyVM();
+
+	// Runs the top level and main() with fresh globals, which stay alive for call().
+	bool run(const std::vector<std::string>& args = {});
+	// Calls a global function defined by the last run.
+	bool call(const std::string& name, const std::vector<Value>& args, Value& result);
+	// The runtime error that stopped the last run or call, empty if there was none.
+	const std::string& error() const;
+};
@@ -2,6 +2,8 @@
 #include "Callable.hpp"
 #include "ToyClass.h"
 
+#include <cctype>
+#include <charconv>
 #include <sstream>
 
 Value::Value()
@@ -38,11 +40,26 @@ void Value::print() const
 	std::cout << *this;
 }
 
-std::string Value::toString()
+std::string Value::toString() const
 {
-	std::stringstream ss;
-	ss << *this;
-	return ss.str();
+	switch (tag)
+	{
+	case TypeTag::BOOL:
+		return std::get<bool>(data) ? "true" : "false";
+	case TypeTag::NUMBER:
+	{
+		char digits[32];
+		return std::string(digits, formatNumber(std::get<double>(data), digits));
+	}
+	case TypeTag::STRING:
+		return std::get<std::string>(data);
+	case TypeTag::CALLABLE:
+		return std::get<std::shared_ptr<Callable>>(data)->name();
+	case TypeTag::INSTANCE:
+		return std::get<std::shared_ptr<ToyInstance>>(data)->klass->name() + " instance";
+	default:
+		return std::string();
+	}
 }
 
 std::ostream& operator<<(std::ostream& os, const Value& val)
@@ -53,8 +70,11 @@ std::ostream& operator<<(std::ostream& os, const Value& val)
 		os << (std::get<bool>(val.data) ? "true" : "false");
 		break;
 	case TypeTag::NUMBER:
-		os << std::get<double>(val.data);
+	{
+		char digits[32];
+		os.write(digits, formatNumber(std::get<double>(val.data), digits));
 		break;
+	}
 	case TypeTag::STRING:
 		os << std::get<std::string>(val.data);
 		break;
@@ -70,3 +90,20 @@ std::ostream& operator<<(std::ostream& os, const Value& val)
 
 	return os;
 }
+
+size_t formatNumber(double num, char* buffer)
+{
+	return std::to_chars(buffer, buffer + 32, num).ptr - buffer;
+}
+
+bool parseNumber(const char* begin, const char* end, double& out)
+{
+	while (begin < end && isspace((unsigned char)*begin))
+		begin++;
+	while (end > begin && isspace((unsigned char)end[-1]))
+		end--;
+	if (begin < end && *begin == '+')
+		begin++;
+	auto res = std::from_chars(begin, end, out);
+	return res.ec == std::errc() && res.ptr == end && begin < end;
+}
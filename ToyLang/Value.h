@@ -31,6 +31,11 @@ public:
 	Value(std::shared_ptr<ToyInstance> val);
 
 	void print() const;
-	std::string toString();
+	std::string toString() const;
 	friend std::ostream& operator<<(std::ostream& os, const Value& val);
 };
+
+// Writes the shortest text that reads back as num into buffer, which must hold 32 chars, and returns its length.
+size_t formatNumber(double num, char* buffer);
+// Reads the whole range as a number ignoring surrounding whitespace, returns false if it is not one.
+bool parseNumber(const char* begin, const char* end, double& out);